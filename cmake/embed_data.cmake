@@ -0,0 +1,32 @@
+# Write OUTPUT, a source file holding every file of DATA_DIR as Assets::EMBEDDED_FILES.
+# Run as: cmake -DDATA_DIR=... -DOUTPUT=... -DSTAMP=... -P embed_data.cmake
+file(GLOB DATA_FILES RELATIVE ${DATA_DIR} ${DATA_DIR}/*)
+list(FILTER DATA_FILES EXCLUDE REGEX "\\.atlas$")  # Built from the images at run time
+list(SORT DATA_FILES)
+
+set(SOURCE "// Generated by cmake/embed_data.cmake from data/, do not edit\n#include \"main.hpp\"\n\n")
+set(TABLE "")
+set(INDEX 0)
+foreach(NAME ${DATA_FILES})
+    if (IS_DIRECTORY ${DATA_DIR}/${NAME})
+        continue()
+    endif()
+    file(READ ${DATA_DIR}/${NAME} HEX HEX)
+    string(LENGTH "${HEX}" SIZE)
+    math(EXPR SIZE "${SIZE} / 2")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," BYTES "${HEX}")
+    # Trailing zero so that empty files still make a valid array
+    string(APPEND SOURCE "static const unsigned char FILE_${INDEX}[] = {${BYTES}0};\n")
+    string(APPEND TABLE "\t{\"${NAME}\", FILE_${INDEX}, ${SIZE}},\n")
+    math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+string(APPEND SOURCE "\nconst Assets::EmbeddedFile Assets::EMBEDDED_FILES[] = {\n${TABLE}\t{NULL, NULL, 0}};\n")
+string(APPEND SOURCE "const int Assets::NB_EMBEDDED_FILES = ${INDEX};\n")
+
+# Only touch the output when it changes, so unrelated data edits don't rebuild it. The stamp is touched every run and
+# is what the build checks against data/, so the script does not run again until data/ changes.
+file(WRITE ${OUTPUT}.tmp "${SOURCE}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
+file(TOUCH ${STAMP})
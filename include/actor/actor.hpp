@@ -10,16 +10,24 @@ class Actor {
 	const char* name;  // actor's name in message logs
 	bool blocks;  // can we walk on this actor?
 	bool fovOnly;  // only display when in fov
+	uint8_t itemKind;  // Item::Kind of items, Item::NO_KIND otherwise
 
 	Attacker* attacker;	 // component, deals damage
 	Destructible* destructible;	 // component, can be damaged
 	Ai* ai;	 // component, self-updating
-	Pickable* pickable;	 // component, item that can be picked and used
+	Pickable* pickable;	 // component, item that can be picked and used, shared with items of the same kind
 	Container* container;  // component, item that can contain more actors
+	SpatialIndex* spatialIndex;	 // index the actor is in, NULL if none
+	int drawOrder;	// rank in Engine::actors, kept by addActor and sendToBack so actors in view draw in list order
 
 	Actor(int x, int y, char ch, const char* name, const TCOD_color_t& color);
 	float getDistance(int cx, int cy) const;
+	// Change position or blocking, keeping the spatial index and free tiles up to date. Never assign x, y or blocks of
+	// indexed actors directly.
+	void moveTo(int newX, int newY);
+	void setBlocks(bool newBlocks);
 	~Actor();
-	void render(tcod::Console& console) const;
+	// Draw on the console, where the map tile (viewX, viewY) is at its top left
+	void render(tcod::Console& console, int viewX, int viewY) const;
 	void update();
 };
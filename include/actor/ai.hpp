@@ -1,5 +1,8 @@
 #pragma once
 
+#include <map>
+
+#include "bitboard.hpp"
 #include "main.hpp"
 
 class Ai {
@@ -20,8 +23,11 @@ class PlayerAi : public Ai {
 		bool& isActionPickUp,
 		bool& isActionInventory,
 		bool& isActionControlsMenu,
+		bool& isActionHistory,
 		bool& isActionDescend,
-		bool& isActionRest);
+		bool& isActionAscend,
+		bool& isActionRest,
+		bool& isActionPerfOverlay);
 };
 
 class MonsterAi : public Ai {
@@ -43,6 +49,8 @@ class TemporaryAi : public Ai {
    protected:
 	int nbTurns;
 	Ai* oldAi;
+
+	friend class SaveGame;
 };
 
 class ConfusedMonsterAi : public TemporaryAi {
@@ -87,3 +95,27 @@ class LichAi : public MonsterAi {
 class DragonAi : public MonsterAi {
 	void update(Actor* owner) override;
 };
+
+// Automatic player used by the headless balance simulator. Greedy policy: drink healing when low, fight adjacent
+// monsters or flee when nearly dead, grab visible items, descend as soon as the stairs are known, otherwise explore.
+class BotAi : public Ai {
+   public:
+	BotAi() = default;
+	void update(Actor* owner) override;
+
+	// Number of uses per item name, for balance statistics
+	std::map<std::string, int> itemUses;
+
+   protected:
+	bool useItems(Actor* owner);
+	bool fightOrFlee(Actor* owner);
+	// Whether an unexplored tile can be reached at all, before searching a path to the closest one
+	bool canExplore(Actor* owner);
+	template <typename Goal>
+	bool stepTowards(Actor* owner, Goal isGoal);
+
+	// Scratch buffer for the breadth first searches
+	std::vector<int> parents;
+	// Scratch boards: items in sight, tiles reachable from the bot and a layer of the map
+	BitBoard visibleItems, reachable, tiles;
+};
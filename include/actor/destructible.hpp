@@ -8,6 +8,7 @@ class Destructible {
 	float hp;  // current health points
 	float defense;	// hit points deflected
 	const char* corpseName;	 // the actor's name once dead/destroyed
+	const char* lastDamageSource;  // name of whoever hurt it last, NULL if never hurt
 
 	Destructible(float maxHp, float defense, const char* corpseName);
 	virtual ~Destructible() {};
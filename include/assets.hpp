@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "main.hpp"
+
+// Files of data/, read from the data directory or from the executable when built with EMBED_DATA
+class Assets {
+   public:
+	// Next to the executable if there is a data directory there, else the first one found from the working directory
+	// upward. Looked up once, throws if there is none.
+	static const std::filesystem::path& getDataDir();
+	// Whole contents of the data file called name, false if there is no such file
+	static bool readFile(const char* name, std::string& contents);
+
+	/*
+		Tileset of the tilesheet image name, made of columnsRows tiles given codepoints by charmap.
+
+		Decoding the image is the slowest part of startup, so the decoded tiles and their codepoints are kept in an
+		atlas file, name.atlas, next to the image or in the pref directory when data is embedded. The atlas is rebuilt
+		when the image changes, going by its modification time, or its hash when embedded.
+	*/
+	static tcod::TilesetPtr loadTilesheet(
+		const char* name, const std::array<int, 2>& columnsRows, std::span<const int> charmap, bool& isFromAtlas);
+
+	// FNV-1a
+	static constexpr uint64_t HASH_SEED = 14695981039346656037ULL;
+	static uint64_t hash(std::string_view bytes, uint64_t hash = HASH_SEED);
+
+#ifdef EMBED_DATA
+	// Generated at build time from data/ by cmake/embed_data.cmake
+	struct EmbeddedFile {
+		const char* name;
+		const unsigned char* data;
+		size_t size;
+	};
+	static const EmbeddedFile EMBEDDED_FILES[];
+	static const int NB_EMBEDDED_FILES;
+#endif
+
+	struct AtlasHeader {
+		char magic[8];
+		uint32_t version;
+		int32_t tileWidth, tileHeight;
+		uint32_t nbTiles;  // tileWidth * tileHeight pixels each, first tile included
+		uint32_t nbCodepoints;	// one tile index per codepoint follows the tiles, 0 for none
+		uint32_t padding;
+		uint64_t sourceStamp;  // modification time or hash of the image
+	};
+	static constexpr uint32_t ATLAS_VERSION = 1;
+};
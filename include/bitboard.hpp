@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/*
+	Set of tiles of a rectangle of the map, one bit per tile. Rows are packed into 64 bit words, bit i of word w of
+	a row being the tile 64 * w + i from the left of the rectangle, so whole board operations go 64 tiles at a time.
+	Tiles are in map coordinates, and tiles outside the rectangle are never in the set.
+*/
+class BitBoard {
+   public:
+	BitBoard() = default;
+	BitBoard(int x, int y, int width, int height) { reset(x, y, width, height); }
+
+	// Cover the rectangle whose top left is (x, y), with no tile set
+	void reset(int x, int y, int width, int height);
+	int getX() const { return x0; }
+	int getY() const { return y0; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	bool isSameRect(const BitBoard& other) const {
+		return x0 == other.x0 && y0 == other.y0 && width == other.width && height == other.height;
+	}
+
+	bool get(int x, int y) const {
+		if (!isInside(x, y)) return false;
+		return (words[wordIndex(x, y)] >> ((x - x0) % 64)) & 1;
+	}
+	void set(int x, int y, bool value = true) {
+		if (!isInside(x, y)) return;
+		uint64_t bit = uint64_t(1) << ((x - x0) % 64);
+		uint64_t& word = words[wordIndex(x, y)];
+		word = value ? word | bit : word & ~bit;
+	}
+	// Set the tiles from x1 to x2 of row y, inclusive
+	void setRow(int y, int x1, int x2);
+	// Set the tiles at most radius away from (x, y), the same ones as Actor::getDistance(x, y) <= radius
+	void setDisc(int x, int y, float radius);
+	void clear() { std::fill(words.begin(), words.end(), 0); }
+
+	bool any() const;
+	int count() const;
+
+	// Intersection, union and difference with a board of the same rectangle
+	BitBoard& operator&=(const BitBoard& other);
+	BitBoard& operator|=(const BitBoard& other);
+	BitBoard& subtract(const BitBoard& other);
+
+	// Add every tile of mask connected to the set through tiles of mask, diagonals included. mask must cover the
+	// same rectangle.
+	void floodFill(const BitBoard& mask);
+
+	// Calls function(x, y) for every tile of the set, row by row
+	template <typename Function>
+	void forEach(Function function) const {
+		for (int row = 0; row < height; row++)
+			for (int w = 0; w < nbWords; w++)
+				for (uint64_t bits = words[row * nbWords + w]; bits; bits &= bits - 1)
+					function(x0 + w * 64 + std::countr_zero(bits), y0 + row);
+	}
+
+	// Words of a row of the rectangle, for filling a board word by word. clipRow() then clears the bits past the
+	// width, which operations expect to be clear.
+	uint64_t* rowWords(int row) { return &words[row * nbWords]; }
+	const uint64_t* rowWords(int row) const { return &words[row * nbWords]; }
+	int getNbWords() const { return nbWords; }
+	void clipRow(int row) {
+		if (nbWords) words[(row + 1) * nbWords - 1] &= lastWordMask;
+	}
+
+   private:
+	int x0 = 0, y0 = 0, width = 0, height = 0;
+	int nbWords = 0;  // per row
+	uint64_t lastWordMask = 0;	// tiles of the last word of a row that are inside the rectangle
+	std::vector<uint64_t> words;
+	std::vector<uint64_t> scratch;	// rows spread sideways, for floodFill()
+
+	bool isInside(int x, int y) const { return x >= x0 && x < x0 + width && y >= y0 && y < y0 + height; }
+	int wordIndex(int x, int y) const { return (y - y0) * nbWords + (x - x0) / 64; }
+	// Each tile of row and its left and right neighbours, into out
+	void spreadRow(const uint64_t* row, uint64_t* out) const;
+};
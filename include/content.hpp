@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "item.hpp"
+#include "main.hpp"
+#include "mapgenerator.hpp"
+#include "random.hpp"
+
+/*
+	Game content: enemy archetypes, item kinds and per floor tables, defined in data/enemies.txt, data/items.txt and
+	data/floors.txt.
+
+	The text files are compiled once into a binary cache next to the save file, made of a CacheHeader followed by the
+	Content itself. Content is a flat struct without pointers, strings being offsets into its string pool, so a valid
+	cache is used straight from its memory mapping once its ids and offsets are checked. The cache is rebuilt whenever
+	the hash of the text files or of the names its ids stand for changes, or when it does not check out.
+*/
+class Content {
+   public:
+	static constexpr int MAX_ARCHETYPES = 16;
+	static constexpr int NB_FLOORS = 20;
+	static constexpr int STRINGS_SIZE = 8192;
+	static constexpr int NB_POTIONS = Item::FIRST_SCROLL - Item::FIRST_POTION;
+	static constexpr int NB_SCROLLS = Item::NB_KINDS - Item::FIRST_SCROLL;
+
+	struct Archetype {
+		uint32_t name, corpseName;
+		char ch;
+		uint8_t ai;	 // Enemy::AiType
+		uint8_t padding[2];
+		float maxHp, defense, power;
+	};
+
+	struct ItemKind {
+		uint32_t name, defaultName, description;
+		char ch;
+		uint8_t r, g, b;
+	};
+
+	struct Floor {
+		int32_t minItems, maxItems;
+		int32_t maxIdScrolls;  // identify scrolls added to the items
+		int32_t nbMonsters;
+		float easyLayoutChance;
+		// Where the stairs go, as fractions of the walk from the player to the farthest tile, on regular and easy
+		// layouts
+		float minStairsDistance, maxStairsDistance;
+		float minEasyStairsDistance, maxEasyStairsDistance;
+		AliasTable<MapGenerator::NB_KINDS> generators;
+		AliasTable<MAX_ARCHETYPES> enemies;
+	};
+
+	int32_t nbArchetypes;
+	Archetype archetypes[MAX_ARCHETYPES];
+	ItemKind items[Item::NB_KINDS];
+	AliasTable<Item::NB_KINDS> itemTable;
+	AliasTable<NB_POTIONS> potionTable;  // potions only, indexed from Item::FIRST_POTION
+	AliasTable<NB_SCROLLS> scrollTable;	 // scrolls only, indexed from Item::FIRST_SCROLL
+	Floor floors[NB_FLOORS];
+	uint32_t stringsSize;
+	char strings[STRINGS_SIZE];
+
+	const char* getString(uint32_t offset) const { return strings + offset; }
+	// Tables of floor level, the last floor for deeper levels
+	const Floor& getFloor(int level) const { return floors[std::clamp(level, 1, NB_FLOORS) - 1]; }
+
+	// Content of the game, loaded on first use from the cache or the text files. Throws if the files are invalid.
+	static const Content& get();
+
+	struct CacheHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t contentSize;  // sizeof(Content), the cache is only valid for the build that wrote it
+		uint64_t hash;	// of the text files
+		uint64_t schemaHash;  // of the names of items, ais and map generators the ids in Content stand for
+	};
+	static constexpr uint32_t CACHE_VERSION = 3;
+
+	static constexpr int NB_FILES = 3;	// enemies, items and floors
+
+   private:
+	static const Content* load();
+	// Whether every count, id, string offset and table of a mapped cache stays within Content
+	bool isValid() const;
+	// Parse the text of the definition files, throws std::runtime_error on the first error
+	static Content* compile(const std::string (&texts)[NB_FILES]);
+};
@@ -4,17 +4,11 @@
 
 class Enemy {
    public:
+	enum AiType : uint8_t { MONSTER_AI, GREMLIN_AI, ELF_AI, LICH_AI, DRAGON_AI };
+
 	static Actor* newEnemy(int x, int y);
 
 	static void setRandomEnemyByFloor(Actor* enemy);
-
-	static void setOrc(Actor* enemy);
-	static void setGoblin(Actor* enemy);
-	static void setGremlin(Actor* enemy);
-	static void setElf(Actor* enemy);
-	static void setOgre(Actor* enemy);
-	static void setLich(Actor* enemy);
-	static void setTroll(Actor* enemy);
-	static void setDragon(Actor* enemy);
-	static void setCentaur(Actor* enemy);
+	// Give enemy the stats and components of an archetype of data/enemies.txt
+	static void setEnemy(Actor* enemy, int archetype);
 };
@@ -1,9 +1,13 @@
 #pragma once
 #include <SDL3/SDL.h>
 
+#include <string>
 #include <vector>
 
+#include "freetileset.hpp"
+#include "gui/perfoverlay.hpp"
 #include "main.hpp"
+#include "spatialindex.hpp"
 
 class Engine {
    public:
@@ -20,56 +24,126 @@ class Engine {
 
 	Engine() = default;
 
+	// Default size of floors, any size up to Map::MAX_SIZE can be asked for with --map-size
 	static constexpr int MAP_WIDTH = 72;
 	static constexpr int MAP_HEIGHT = 32;
+	// Part of the map shown above the Gui panel, it follows the player on larger floors
+	static constexpr int VIEW_WIDTH = 72;
+	static constexpr int VIEW_HEIGHT = 32;
 	static constexpr int GUI_PANEL_HEIGHT = 8;
-	static constexpr int CONSOLE_WIDTH = MAP_WIDTH;
-	static constexpr int CONSOLE_HEIGHT = MAP_HEIGHT + GUI_PANEL_HEIGHT;
+	static constexpr int CONSOLE_WIDTH = VIEW_WIDTH;
+	static constexpr int CONSOLE_HEIGHT = VIEW_HEIGHT + GUI_PANEL_HEIGHT;
+	// Actors further than this from the player along either axis wait, and monsters spawn, wander and search paths
+	// within it. A default size floor is in range from anywhere on it, so only larger floors are affected.
+	static constexpr int ACTIVE_RANGE = 80;
 
 	Uint32 lastEventType;
 	SDL_KeyboardEvent lastKeyboardEvent;
 	Uint8 lastMouseButton;
-	int lastMouseTileX, lastMouseTileY;
+	int lastMouseTileX, lastMouseTileY;	 // on the console
+	// Map tile at the top left of the view
+	int viewX = 0, viewY = 0;
+	// Map tile under the mouse, false if the mouse is not over the view
+	bool getMouseMapTile(int& x, int& y) const;
 
 	SDL_AppResult init(int argc, char** argv);
 	SDL_AppResult iterate();
 	SDL_AppResult handleEvent(const SDL_Event& event);
 	void shutdown();
 
+	// Redraw on the next iteration even if the game is waiting for input. Map, actors, Gui and menus only change while
+	// a turn or a menu input is processed, which always redraws, so this is only needed for changes from outside.
+	void markDirty() { isFrameDirty = true; }
+
+	void updateOtherActors();
+	// Append to the actor list
+	void addActor(Actor* actor);
 	void removeActor(Actor* actor);
 	void sendToBack(Actor* actor);
 	Actor* getActor(int x, int y) const;
 	Actor* getClosestMonster(int x, int y, float range) const;
 
+	// Size of the floors newGame() and nextLevel() create
+	int mapWidth = MAP_WIDTH, mapHeight = MAP_HEIGHT;
+	// Generator of the floors they create, NB_KINDS to draw it from the table of each floor. Set with --map-generator.
+	MapGenerator::Kind mapGenerator = MapGenerator::NB_KINDS;
+	// Debug overlay, whose counters are bumped from anywhere in the engine
+	PerfOverlay perfOverlay;
 	int level;
 	int monsterSpawnRate;
 	float winEffect;
 	void createNatureActor();
+	// Go down or up a floor. Floors left are kept compressed in visitedFloors and restored as they were when entered
+	// again, new ones are generated.
 	void nextLevel();
+	void previousLevel();
+
+	// Create or free the player, first floor, Gui and name tracker. Needs no window, so headless tools can drive the
+	// engine directly.
+	void newGame();
+	void endGame();
+	// Free the current map and every actor except player and stairs
+	void clearFloor();
+	// Snapshots of the floors the player left, by level. Empty for the current floor and floors never visited.
+	std::vector<std::vector<uint8_t>> visitedFloors;
+	// Draw the view, actors in it and the Gui. Costs the same on any size of map.
+	void render(tcod::Console& console);
 
 	// List of actors that will be rendered and updated each frame or turn, including player, item on ground, etc.
 	// Memories of these will be released on destructing the engine class
 	std::vector<Actor*> actors;
-	Actor* player;
-	Actor* stairs;
-	Actor* nature;
-
-	Map* map;
-	Gui* gui;
-	NameTracker* nameTracker;
+	// Actors of the list by position, for range queries
+	SpatialIndex spatialIndex{MAP_WIDTH, MAP_HEIGHT};
+	// Tiles of the current map nothing blocks, for spawning and picking destinations
+	FreeTileSet freeTiles;
+	Actor* player = NULL;
+	Actor* stairs = NULL;
+	Actor* nature = NULL;
+	// Where the player arrived on the floor, NULL on the first one
+	Actor* upStairs = NULL;
+
+	Map* map = NULL;
+	Gui* gui = NULL;
+	NameTracker* nameTracker = NULL;
 
 	int fovRadius;
 
+	// Snapshot the game every AUTOSAVE_INTERVAL turns, so a crash loses at most that many turns
+	static constexpr int AUTOSAVE_INTERVAL = 20;
+	AutoSaver* autoSaver = NULL;
+
 	~Engine();
 
+	// Path of fileName in the per user writable directory, empty if there is no such directory
+	static std::filesystem::path getPrefPath(const char* fileName);
+
    private:
-	std::filesystem::path getDataDir();
-	void render(tcod::Console& console);
+	// Where the current run is kept between sessions, empty if there is no writable location
+	std::filesystem::path getSavePath() { return getPrefPath("save.dat"); }
+	// Keep the player in the middle of the view, and the view on the map
+	void updateView();
+	// Add the time since the last phase ended to the startup report
+	void endStartupPhase(const char* phase);
+	// Keep the current floor and enter the one of newLevel
+	void changeLevel(int newLevel);
 
 	tcod::Console console;
 	tcod::Context context;
 
 	bool computeFov;
+	bool isFrameDirty = true;
+	FramePacer* framePacer = NULL;
+	// Background brightening per second on the victory screen
+	static constexpr float WIN_EFFECT_SPEED = 12.0F;
+	// Time to first frame by phase, logged once the first frame is presented
+	Uint64 startupTicks = 0, phaseTicks = 0;
+	std::string startupReport;
+	int turnsSinceAutoSave = 0;
+	// Order of the next actor added to the front or back of the list, see Actor::drawOrder
+	int nextDrawOrder = 0, nextBackDrawOrder = -1;
+	std::vector<Actor*> actorsInView;  // scratch buffer for render()
 };
 
-extern Engine engine;
+// One engine per thread so that headless tools can run independent games in parallel. The game itself only ever
+// touches it from the main thread.
+extern thread_local Engine engine;
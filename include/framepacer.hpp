@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <string>
+
+// Decides how often the game loop runs. Frames that draw something run at the display rate, or maxFps if set, so
+// animations stay smooth. While waiting for input the loop sleeps until the next event, waking at most idleFps times
+// per second for background work.
+class FramePacer {
+   public:
+	struct Settings {
+		bool vsync = true;
+		int maxFps = 0;	 // 0 for the display rate, or FALLBACK_FPS without vsync
+		int idleFps = 4;  // 0 to only wake on events
+		int reportInterval = 0;	 // seconds between reports in the log, 0 for only on exit
+	};
+	// Reads --no-vsync, --max-fps N, --idle-fps N and --frame-report N, leaving other arguments to libtcod
+	static Settings parseArguments(int argc, char** argv);
+
+	struct Stats {
+		int frames = 0;
+		int idleWakeUps = 0;
+		// From beginFrame to the end of endFrame's sleep, presenting included
+		Uint64 frameNsTotal = 0, frameNsMax = 0;
+		Uint64 lastFrameNs = 0;
+		Uint64 startTicks = 0;
+		double startCpu = 0.0;	// getCpuSeconds()
+	};
+
+	explicit FramePacer(const Settings& settings);
+	const Settings& getSettings() const { return settings; }
+
+	// Sleep until the next event or idle wake-up, for iterations with nothing to draw
+	void waitForEvent();
+	// Call when starting an iteration that draws. Returns the seconds since the previous one, at most a tenth of a
+	// second, for animations to advance by.
+	float beginFrame();
+	// Call after presenting, sleeps out the rest of the frame if the rate is capped
+	void endFrame();
+
+	const Stats& getStats() const { return stats; }
+	bool isReportDue() const;
+	// Frame times and CPU usage since the last report, then start a new one
+	std::string report();
+
+   private:
+	static constexpr int FALLBACK_FPS = 60;
+
+	Settings settings;
+	Stats stats;
+	Uint64 frameStart = 0;
+	Uint64 lastFrameStart = 0;
+
+	// Processor time used by every thread of the process so far, autosave included
+	static double getCpuSeconds();
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "random.hpp"
+
+class Map;
+class Actor;
+
+// Walkable tiles with no blocking actor on them, kept in a dense array for constant time uniform sampling. Updated
+// as actors are added, removed or moved, see Engine::addActor and Actor::moveTo.
+class FreeTileSet {
+   public:
+	// Start over from the walkable tiles of map and the blocking actors on it
+	void build(const Map& map, const std::vector<Actor*>& actors);
+	void setWalkable(int x, int y, bool isWalkable);
+	void addBlocker(int x, int y);
+	void removeBlocker(int x, int y);
+	void moveBlocker(int oldX, int oldY, int newX, int newY);
+
+	int size() const { return (int)tiles.size(); }
+	bool contains(int x, int y) const { return isInside(x, y) && positions[x + y * width] >= 0; }
+
+	// Uniformly random free tile, false if there is none
+	bool sample(int& x, int& y) const {
+		if (tiles.empty()) return false;
+		int tile = tiles[Random::instance().getInt(0, (int)tiles.size() - 1)];
+		x = tile % width;
+		y = tile / width;
+		return true;
+	}
+
+	// Uniformly random free tile for which predicate(x, y) holds, false if there is none. A few random picks are tried
+	// first, then every free tile is, so it always ends in bounded time.
+	template <typename Predicate>
+	bool sample(int& x, int& y, Predicate predicate) const {
+		for (int tries = 0; tries < 16; tries++)
+			if (sample(x, y) && predicate(x, y)) return true;
+		int nbMatching = 0;
+		for (int tile : tiles)
+			if (predicate(tile % width, tile / width)) nbMatching++;
+		if (nbMatching == 0) return false;
+		int pick = Random::instance().getInt(0, nbMatching - 1);
+		for (int tile : tiles)
+			if (predicate(tile % width, tile / width) && pick-- == 0) {
+				x = tile % width;
+				y = tile / width;
+				break;
+			}
+		return true;
+	}
+
+	// Same as sample(x, y, predicate), among tiles at most range away from (centerX, centerY) along each axis. Costs
+	// at most the area of that square, whatever the size of the map.
+	template <typename Predicate>
+	bool sampleNear(int centerX, int centerY, int range, int& x, int& y, Predicate predicate) const {
+		int x1 = std::max(0, centerX - range), x2 = std::min(width - 1, centerX + range);
+		int y1 = std::max(0, centerY - range), y2 = std::min(height - 1, centerY + range);
+		// The whole map is better sampled from the dense array
+		if (x1 == 0 && y1 == 0 && x2 == width - 1 && y2 == height - 1) return sample(x, y, predicate);
+		if (x1 > x2 || y1 > y2) return false;
+		Random& rng = Random::instance();
+		for (int tries = 0; tries < 16; tries++) {
+			x = rng.getInt(x1, x2);
+			y = rng.getInt(y1, y2);
+			if (contains(x, y) && predicate(x, y)) return true;
+		}
+		int nbMatching = 0;
+		for (int ty = y1; ty <= y2; ty++)
+			for (int tx = x1; tx <= x2; tx++)
+				if (contains(tx, ty) && predicate(tx, ty)) nbMatching++;
+		if (nbMatching == 0) return false;
+		int pick = rng.getInt(0, nbMatching - 1);
+		for (int ty = y1; ty <= y2; ty++)
+			for (int tx = x1; tx <= x2; tx++)
+				if (contains(tx, ty) && predicate(tx, ty) && pick-- == 0) {
+					x = tx;
+					y = ty;
+					return true;
+				}
+		return true;
+	}
+
+   private:
+	int width = 0, height = 0;
+	std::vector<uint8_t> walkable;
+	std::vector<uint8_t> blockers;	// blocking actors per tile
+	std::vector<int> tiles;	 // free tiles as x + y * width, in no particular order
+	std::vector<int> positions;	 // index of each tile in tiles, -1 if not free
+
+	bool isInside(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+	// Add or remove tile from the free tiles after its state changed
+	void update(int tile);
+};
@@ -12,24 +12,94 @@ class Gui {
 	Gui();
 	~Gui();
 	void render(tcod::Console& mainConsole);
-	void message(std::string text, const tcod::ColorRGB& color = DEFAULT_MESSAGE_COLOR_LIGHT_GREY);
+	// Game events that are logged as data and only turned into text when displayed or exported
+	enum Event : uint8_t {
+		TEXT,  // plain line of text
+		ATTACK,	 // subject attacks object for value HP
+		ATTACK_NO_EFFECT,  // subject attacks object but it has no effect
+		ATTACK_IN_VAIN,	 // subject attacks object, which is already dead
+		BURN,  // subject gets burned for value HP
+		POWER_UP,  // subject becomes more powerful
+		POWER_DOWN,	 // subject becomes weaker
+		DEATH,	// subject is dead
+		CUSTOM,	 // custom printf format, given subject (%s) and value (%g)
+		NB_EVENTS
+	};
+
+	// Log text, one line per '\n'. Never allocates: lines are copied into the fixed size log.
+	void message(std::string_view text, const tcod::ColorRGB& color = DEFAULT_MESSAGE_COLOR_LIGHT_GREY);
+	// Log an event on one line. Only names and numbers are stored, so the actors' names and format must outlive the
+	// log, as names of actors always do.
+	void event(
+		Event event,
+		const Actor* subject,
+		const Actor* object = NULL,
+		float value = 0.0F,
+		const tcod::ColorRGB& color = DEFAULT_MESSAGE_COLOR_LIGHT_GREY);
+	// Log a CUSTOM event, where format is a literal with a %s for name and a %g for value
+	void event(
+		const char* format,
+		const char* name,
+		float value,
+		const tcod::ColorRGB& color = DEFAULT_MESSAGE_COLOR_LIGHT_GREY);
+	// Write the log as one JSON object per line
+	void exportLog(FILE* file) const;
+	static constexpr int LINE_BUFFER_SIZE = 80;	// enough for any line of the log
+	// Lines of the whole session, the ones that left the log followed by the ones still in it
+	int getHistorySize() const;
+	// i-th line of the session from the oldest one, formatted into buffer if needed
+	std::string_view getHistoryLine(int i, char* buffer, size_t size, tcod::ColorRGB& color, int& count);
+	size_t getHistoryMemoryUsage() const;
+	// Stop keeping lines that leave the log, for headless games
+	void disableHistory();
 	void openInventory(Actor* owner);
 	void update();
 
 	friend class Menu;
+	friend class SaveGame;
 	bool isMenuOpen;
 	Menu* menu;
 
    protected:
 	tcod::Console guiConsole;
 
+	// One line of the log, stored inline
 	struct Message {
-		const std::string text;
-		const tcod::ColorRGB& color;
-		Message(std::string text, const tcod::ColorRGB& color);
-		~Message();
+		static constexpr int MAX_LENGTH = LINE_BUFFER_SIZE - 1;	// longer lines are cut
+		enum Flags : uint8_t { SUBJECT_IS_PLAYER = 1, OBJECT_IS_PLAYER = 2 };
+
+		Event event;
+		uint8_t flags;
+		uint8_t length;	 // of text
+		tcod::ColorRGB color;
+		int count;	// identical consecutive messages are kept once with a counter
+		float value;
+		const char* format;	 // CUSTOM only
+		const char* subject;
+		const char* object;
+		char text[MAX_LENGTH + 1];	// TEXT only
+
+		// Text of the line, formatted into buffer unless it is plain text
+		std::string_view getText(char* buffer, size_t size) const;
+		bool isSameAs(const Message& other) const;
+		static std::string_view truncate(std::string_view line) { return line.substr(0, MAX_LENGTH); }
 	};
-	std::vector<Message*> log;
+
+	// Ring buffer of the last LOG_CAPACITY lines, the oldest being overwritten first
+	static constexpr int LOG_CAPACITY = 64;
+	std::array<Message, LOG_CAPACITY> log;
+	int logStart;  // index of the oldest line
+	int logSize;
+	int lastMessageLines;  // number of lines added by the last message, for coalescing
+	MessageHistory* history;  // lines that left the log, NULL if disabled
+
+	// i-th line from the oldest one
+	const Message& logLine(int i) const { return log[(logStart + i) % LOG_CAPACITY]; }
+	Message& logLine(int i) { return log[(logStart + i) % LOG_CAPACITY]; }
+	void addLine(std::string_view text, const tcod::ColorRGB& color, int count = 1);
+	void addEvent(const Message& message);
+	// Make room for a new line at the end of the log and return it
+	Message& pushLine();
 
 	void renderBar(
 		int x,
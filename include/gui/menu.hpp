@@ -1,5 +1,6 @@
 #pragma once
 
+#include "bitboard.hpp"
 #include "main.hpp"
 
 class Menu {
@@ -71,6 +72,9 @@ class TilePickMenu : public Menu {
 	TilePickRange pickRange;
 
 	float maxRange = 12.0;
+	// Tiles that can be picked: seen, walkable and in range. The player can not move while picking, so they are found
+	// once from the map layers.
+	BitBoard pickableTiles;
 };
 
 class ItemPickMenu : public Menu {
@@ -121,3 +125,30 @@ class ControlsMenu : public Menu {
 	static constexpr int CONTROL_WIDTH = 60;
 	static constexpr int CONTROL_HEIGHT = 30;
 };
+
+// Scrollable, searchable view of every message of the session. Only the visible lines are read, so the cost of a
+// frame does not depend on the length of the history.
+class HistoryMenu : public Menu {
+   public:
+	HistoryMenu();
+	~HistoryMenu() = default;
+
+	virtual void update() override;
+	virtual void render(tcod::Console& mainConsole) override;
+
+   protected:
+	tcod::Console historyConsole;
+	int bottomLine;	 // one past the last line shown
+	int matchLine;	// line found by the last search, -1 if none
+	bool onSearch;	// typing the search string
+	std::string searchString;
+
+	void scrollTo(int newBottomLine);
+	// Find the next line containing searchString, going backward (older) or forward, and scroll to it
+	bool search(bool isBackward);
+
+	static constexpr int HISTORY_WIDTH = 70;
+	static constexpr int HISTORY_HEIGHT = 38;
+	static constexpr int PAGE_LINES = HISTORY_HEIGHT - 2;	 // without the title and help lines
+	static constexpr size_t MAX_SEARCH_LENGTH = 30;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "main.hpp"
+
+// Append-only store of every message line of a session. Lines are packed into chunks of LINES_PER_CHUNK, and full
+// chunks are compressed, so hundreds of thousands of lines fit in a few MB. Reading decodes at most one chunk.
+class MessageHistory {
+   public:
+	static constexpr int LINES_PER_CHUNK = 256;
+
+	struct Line {
+		std::string_view text;
+		tcod::ColorRGB color;
+		int count;
+	};
+
+	MessageHistory(bool isCompressed = true);
+
+	void add(std::string_view text, const tcod::ColorRGB& color, int count);
+	int size() const { return nbLines; }
+	// Line at index, from 0 to size() - 1. Its text is valid until the next call to get() or add(), which may move
+	// the chunks it points into.
+	Line get(int index);
+	// Bytes used by the stored lines
+	size_t getMemoryUsage() const;
+
+   private:
+	struct Chunk {
+		std::vector<uint8_t> data;
+		uint32_t rawSize;
+		bool isCompressed;
+	};
+
+	bool isCompressed;
+	int nbLines;
+	std::vector<Chunk> chunks;	// full chunks
+
+	// Chunk being filled, uncompressed. Every line is r, g, b, count (4 bytes), length (1 byte) then the text.
+	std::vector<uint8_t> openChunk;
+	std::vector<uint32_t> openOffsets;
+
+	// Last chunk read by get()
+	int decodedIndex;
+	std::vector<uint8_t> decodedChunk;
+	std::vector<uint32_t> decodedOffsets;
+
+	void sealOpenChunk();
+	static Line decodeLine(const uint8_t* line);
+};
@@ -1,9 +1,11 @@
 #pragma once
 
-#include <map>
+#include <string>
 
+#include "item.hpp"
 #include "main.hpp"
 
+// What the player knows of every item kind. Tables are indexed by Item::Kind, so names are found without allocating.
 class NameTracker {
    public:
 	// Use rng for mapping names. rng will be deleted when nametracker is destroyed.
@@ -17,17 +19,20 @@ class NameTracker {
 	void identifyItem(Actor* itemActor);
 	void forgetEverything();
 
-	const char* getDisplayName(const Actor* itemActor);
+	const char* getDisplayName(const Actor* itemActor) const;
 
-	const char* getDescription(const Actor* itemActor);
+	const char* getDescription(const Actor* itemActor) const;
 
 	static constexpr auto MAX_CALL_STRING_LENGTH = 30;
 
    protected:
 	Random* rng;
 
-	std::map<std::string, bool> identifyStatus;
-	std::map<std::string, std::string> callNames;
-	std::map<char, std::map<std::string, std::string>> defaultNames;
-	std::map<std::string, std::string> descriptions;
+	bool isIdentified[Item::NB_KINDS];
+	char callNames[Item::NB_KINDS][MAX_CALL_STRING_LENGTH + 1];	// empty if not called
+	const char* defaultNames[Item::NB_KINDS];  // shuffled among potions and among scrolls
+
+	void setCallName(Item::Kind kind, std::string_view callName);
+
+	friend class SaveGame;
 };
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <array>
+#include <cstdint>
+
+#include "main.hpp"
+
+/*
+	Debug overlay drawn in the Gui panel in place of the message log, toggled with F3. Shows frame and turn times
+	with a sparkline of the last ones, path searches, nodes expanded and FoV computations of the last turn, actors by
+	kind and heap usage. Counters are plain increments kept whether the overlay is shown or not, everything else is
+	only timed or measured while it is.
+*/
+class PerfOverlay {
+   public:
+	struct Counters {
+		uint64_t pathSearches;	// Map::directionAtTarget() calls
+		uint64_t nodesExpanded;	 // tiles popped by those searches
+		uint64_t fovComputes;
+	};
+	// Bumped by the engine, and moved to the last turn's counters at the end of every turn
+	Counters counters = {};
+	bool isVisible = false;
+
+	void toggle();
+	// Around player and monster updates, times the turn while visible
+	void beginTurnWork() {
+		if (isVisible) workStart = SDL_GetTicksNS();
+	}
+	void endTurnWork() {
+		if (isVisible) turnNs += SDL_GetTicksNS() - workStart;
+	}
+	// Once every actor has played
+	void endTurn();
+	// Once a frame is presented, with its duration
+	void endFrame(Uint64 frameNs);
+
+	// Draw the overlay with its top left at (x, y), 7 rows high and from x to the right edge of console
+	void render(tcod::Console& console, int x, int y) const;
+
+   private:
+	static constexpr int HISTORY_SIZE = 35;	 // columns of the sparklines
+
+	// Ring buffer of the last HISTORY_SIZE samples, oldest first
+	struct History {
+		std::array<float, HISTORY_SIZE> values = {};
+		int next = 0, size = 0;
+		void add(float value);
+		float get(int i) const { return values[(next - size + i + HISTORY_SIZE) % HISTORY_SIZE]; }
+		float last() const { return size ? get(size - 1) : 0.0F; }
+		float max() const;
+	};
+	History frameMs, turnMs;
+	Counters lastTurn = {};
+	Uint64 workStart = 0, turnNs = 0;
+
+	// Two rows high, one column per sample scaled to the largest one, spikes above twice the median in red
+	static void renderSparkline(tcod::Console& console, int x, int y, const History& history);
+	// Bytes of heap in use, -1 if the platform does not tell
+	static long long getHeapBytes();
+};
@@ -4,25 +4,48 @@
 
 class Item {
    public:
+	// Item kinds, potions first then scrolls. Items keep their kind in Actor::itemKind.
+	enum Kind : uint8_t {
+		POTION_OF_FULL_HEALING,
+		POTION_OF_STRENGTH,
+		POTION_OF_PROTECTION,
+		POTION_OF_POISON,
+		POTION_OF_AMNESIA,
+		POTION_OF_CONFUSION,
+		POTION_OF_FIRE,
+		SCROLL_OF_IDENTIFY,
+		SCROLL_OF_TELEPORTATION,
+		SCROLL_OF_MAPPING,
+		SCROLL_OF_CONFUSION,
+		SCROLL_OF_FIREBALL,
+		SCROLL_OF_LIQUIFY,
+		SCROLL_OF_SUMMON_MONSTERS,
+		NB_KINDS,
+		FIRST_POTION = POTION_OF_FULL_HEALING,
+		FIRST_SCROLL = SCROLL_OF_IDENTIFY,
+		NO_KIND = 0xFF	// not an item
+	};
+
 	static Actor* newItem(int x, int y);
 
+	// Immutable description of an item kind, from data/items.txt. Every item of a kind points to the same pickable, so
+	// items own nothing.
+	struct Prototype {
+		const char* name;
+		char ch;
+		tcod::ColorRGB color;
+		Pickable* pickable;
+	};
+	static const Prototype& getPrototype(Kind kind);
+
+	// Turn item into an item of kind, without allocating
+	static void setItem(Actor* item, Kind kind);
 	static void setRandomItem(Actor* item);
+	// Turn item into the item kind called name, returns false if there is no such kind
+	static bool setItemByName(Actor* item, const char* name);
+	// Kind called name, NO_KIND if there is none
+	static Kind getKindByName(std::string_view name);
+	static const char* getName(Kind kind);
 	static void setRandomPotion(Actor* item);
 	static void setRandomScroll(Actor* item);
-
-	static void setPotionOfFullHealing(Actor* item);
-	static void setPotionOfStrength(Actor* item);
-	static void setPotionOfProtection(Actor* item);
-	static void setPotionOfPoison(Actor* item);
-	static void setPotionOfAmnesia(Actor* item);
-	static void setPotionOfConfusion(Actor* item);
-	static void setPotionOfFire(Actor* item);
-
-	static void setScrollOfIdentify(Actor* item);
-	static void setScrollOfTeleportation(Actor* item);
-	static void setScrollOfMapping(Actor* item);
-	static void setScrollOfConfusion(Actor* item);
-	static void setScrollOfFireball(Actor* item);
-	static void setScrollOfLiquify(Actor* item);
-	static void setScrollOfSummonMonsters(Actor* item);
 };
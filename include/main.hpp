@@ -11,11 +11,21 @@ class Container;
 class Map;
 class Gui;
 class Menu;
+class MessageHistory;
 class NameTracker;
 class Effect;
 class TargetSelector;
 class Item;
 class Enemy;
+class Content;
+class AutoSaver;
+class Assets;
+class FramePacer;
+class PerfOverlay;
+class SpatialIndex;
+class FreeTileSet;
+class BitBoard;
+class MapGenerator;
 #include "actor/actor.hpp"
 #include "actor/ai.hpp"
 #include "actor/attacker.hpp"
@@ -24,11 +34,25 @@ class Enemy;
 #include "actor/effect.hpp"
 #include "actor/pickable.hpp"
 #include "actor/targetselector.hpp"
+#include "assets.hpp"
+#include "bitboard.hpp"
+#include "content.hpp"
 #include "enemy.hpp"
 #include "engine.hpp"
+#include "framepacer.hpp"
+#include "freetileset.hpp"
 #include "gui/gui.hpp"
 #include "gui/menu.hpp"
+#include "gui/messagehistory.hpp"
 #include "gui/nametracker.hpp"
+#include "gui/perfoverlay.hpp"
 #include "item.hpp"
 #include "map.hpp"
+#include "mapgenerator.hpp"
 #include "random.hpp"
+#include "save/atomicfile.hpp"
+#include "save/autosaver.hpp"
+#include "save/mappedfile.hpp"
+#include "save/savegame.hpp"
+#include "spatialindex.hpp"
+#include "timing.hpp"
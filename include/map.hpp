@@ -1,26 +1,65 @@
 #pragma once
 
+#include "bitboard.hpp"
 #include "main.hpp"
 
-struct Tile {
-	bool explored;	// has the player already seen this tile ?
-	Tile() : explored(false) {}
+// Square block of map tiles. Chunks are only allocated once a tile in them is dug or seen, so solid rock costs
+// nothing, and a tile is found with a division instead of a row of the whole map.
+struct MapChunk {
+	// A row of a chunk is one BitBoard word
+	static constexpr int SIZE = 64;
+	static constexpr int NB_LAYERS = 3;
+	// Bit x of row y of layers[i] is Map::TileFlag 1 << i of tile (x, y) of the chunk
+	uint64_t layers[NB_LAYERS][SIZE];
+	uint16_t roomIds[SIZE * SIZE];
+	MapChunk();
+
+	uint8_t getFlags(int x, int y) const {
+		uint8_t flags = 0;
+		for (int i = 0; i < NB_LAYERS; i++) flags |= ((layers[i][y] >> x) & 1) << i;
+		return flags;
+	}
+	void setFlags(int x, int y, uint8_t flags) {
+		for (int i = 0; i < NB_LAYERS; i++)
+			layers[i][y] = (layers[i][y] & ~(uint64_t(1) << x)) | (uint64_t((flags >> i) & 1) << x);
+	}
+};
+
+struct Room {
+	int x1, y1, x2, y2;	 // bounds, inclusive
+	int nbTiles;  // floor tiles belonging to the room
+	std::vector<uint16_t> neighbors;  // rooms reached by a corridor without crossing another room
 };
 
 class Map {
    public:
 	int width, height;
+	// Size limits, the largest keeps tile indices x + y * width in an int
+	static constexpr int MIN_SIZE = 16, MAX_SIZE = 4096;
+	// Read width and height from "WIDTHxHEIGHT", false and unchanged unless both are from MIN_SIZE to MAX_SIZE
+	static bool parseSize(const char* text, int& width, int& height);
+
+	enum TileFlag : uint8_t { TILE_WALKABLE = 1, TILE_TRANSPARENT = 2, TILE_EXPLORED = 4 };
 
-	Map(int width, int height);
+	Map(int width, int height, bool generate = true);
 	~Map();
-	bool isWalkable(int x, int y) const;
+	bool isWalkable(int x, int y) const { return getFlags(x, y) & TILE_WALKABLE; }
+	bool isTransparent(int x, int y) const { return getFlags(x, y) & TILE_TRANSPARENT; }
 	bool canWalk(int x, int y) const;
 	void setWalkable(int x, int y, bool newWalkableValue = true);
-	bool isInFov(int x, int y) const;
-	bool isExplored(int x, int y) const;
+	// Seen by the last computeFov(), which also marked it explored
+	bool isInFov(int x, int y) const { return fov.get(x, y); }
+	bool isExplored(int x, int y) const { return getFlags(x, y) & TILE_EXPLORED; }
+	// Whole layers for region operations. Fill tiles with the tiles of its rectangle having flag, a word of 64 tiles
+	// at a time. Tiles off the map have none.
+	void getTiles(TileFlag flag, BitBoard& tiles) const;
+	// Tiles seen by the last computeFov(), over the square around the player
+	const BitBoard& getFov() const { return fov; }
 	std::array<int, 2> findSpotsNear(int x, int y);
+	// Only the square of fovRadius around the player is looked at, whatever the size of the map
 	void computeFov();
-	void render(tcod::Console& console) const;
+	// Draw the tiles of the view whose top left is (viewX, viewY), chunk by chunk
+	void render(tcod::Console& console, int viewX, int viewY) const;
 
 	void dig(int x1, int y1, int x2, int y2);
 	void createRoom(bool first, int x1, int y1, int x2, int y2);
@@ -28,19 +67,82 @@ class Map {
 	void addOneNewMonster();
 	void addItems();
 
-	// calculate dx, dy for target at (x, y) from (cx, cy). dx, dy may be both 0.
+	// calculate dx, dy for target at (x, y) from (cx, cy). dx, dy may be both 0. Paths are searched within
+	// Engine::ACTIVE_RANGE of (cx, cy), towards the closest edge of that square when the target is beyond it.
 	std::array<int, 2> directionAtTarget(int x, int y, int cx, int cy);
 
 	bool isMapRevealed, isEasyLayout;
 	void revealMap();
 	void cancelRevealMap();
 
-	// x1, y1, x2, y2
-	std::vector<std::array<int, 4>> roomRecords;
+	std::vector<Room> rooms;
+	// L-shaped corridors from the center of a room (x1, y1) to the center of the next one (x2, y2)
+	std::vector<std::array<int, 4>> corridorRecords;
+
+	// Room ids of tiles, indices into rooms or one of these
+	static constexpr uint16_t NO_ROOM = 0xFFFF;	 // rock, or out of the map
+	static constexpr uint16_t CORRIDOR = 0xFFFE;
+	// Stamp the room id of every tile and fill in room metadata, from rooms bounds and corridorRecords
+	void indexRooms();
+	uint16_t getRoomAt(int x, int y) const {
+		const MapChunk* chunk = getChunk(x, y);
+		return chunk ? chunk->roomIds[chunkIndex(x, y)] : NO_ROOM;
+	}
+	// Free tiles of every room, and count of them spread out, see map.cpp. Tiles are x + y * width.
+	std::vector<int> getFreeRoomTiles() const;
+	std::vector<int> spreadTiles(std::vector<int> candidates, int count, const std::vector<int>& avoid) const;
+	// Actors standing in the room, not counting its walls
+	void getActorsInRoom(int room, std::vector<Actor*>& actors) const;
+	// Random floor tile of the room with no blocking actor on it, false if there is none
+	bool getRandomFreeTile(int room, int& x, int& y) const;
+
+	// Generation pass run once a MapGenerator has dug the layout and placed the player. One breadth first search from
+	// the player finds the walking distance to every reachable tile, walkable tiles it did not reach are filled in as
+	// rock, and the stairs go to a room tile whose distance is in the band of the floor, see Content::Floor.
+	void connectAndPlaceStairs();
+	struct LayoutStats {
+		MapGenerator::Kind generator;  // that dug the layout
+		double generateUs;	// time spent digging it
+		int components;	 // separate groups of walkable tiles before the pass
+		int filledTiles;  // walkable tiles filled in as unreachable
+		int farthestDistance;  // steps from the player to the farthest reachable tile
+		int stairsDistance;	 // steps from the player to the stairs
+		double passUs;	// time spent in the pass
+	} layoutStats = {};
 
    protected:
-	// Tile at (x, y) is indexed at x + y * width
-	Tile* tiles;
-	TCODMap* map;
-	friend class BspListener;
+	// Chunks row by row, NULL where every tile is unexplored rock
+	int chunksWidth, chunksHeight;
+	std::vector<MapChunk*> chunks;
+	// Transparency of the square around the player of the last computeFov(), whose top left is (fovX, fovY), and
+	// what was seen of it
+	TCODMap* fovMap;
+	int fovX, fovY;
+	BitBoard fov;
+	// Scratch buffers for directionAtTarget(), over its search square
+	std::vector<int> pathDist;
+	std::vector<uint8_t> pathBlocked;
+
+	// Chunk of tile (x, y), NULL if it is rock or out of the map
+	MapChunk* getChunk(int x, int y) const {
+		if (x < 0 || x >= width || y < 0 || y >= height) return NULL;
+		return chunks[x / MapChunk::SIZE + y / MapChunk::SIZE * chunksWidth];
+	}
+	// Chunk of tile (x, y), allocated if needed. (x, y) must be on the map.
+	MapChunk& makeChunk(int x, int y);
+	static int chunkIndex(int x, int y) { return x % MapChunk::SIZE + y % MapChunk::SIZE * MapChunk::SIZE; }
+	uint8_t getFlags(int x, int y) const {
+		const MapChunk* chunk = getChunk(x, y);
+		return chunk ? chunk->getFlags(x % MapChunk::SIZE, y % MapChunk::SIZE) : 0;
+	}
+	// Row y of a layer of the chunks in column chunkX, 0 for rock and off the map
+	uint64_t getChunkRow(int layer, int chunkX, int y) const {
+		if (chunkX < 0 || chunkX >= chunksWidth || y < 0 || y >= height) return 0;
+		const MapChunk* chunk = chunks[chunkX + y / MapChunk::SIZE * chunksWidth];
+		return chunk ? chunk->layers[layer][y % MapChunk::SIZE] : 0;
+	}
+	void setFlags(int x, int y, uint8_t flags);
+	// Add flag to the tiles of tiles, the reverse of getTiles(). Chunks are allocated as needed.
+	void addTiles(TileFlag flag, const BitBoard& tiles);
+	friend class SaveGame;
 };
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string_view>
+
+#include "main.hpp"
+
+/*
+	Layout of a new floor. A generator digs into a map of solid rock, records its rooms and L-shaped corridors if it
+	has any, and puts the player somewhere walkable. Map::Map then fills in what the player can not reach, places the
+	stairs and indexes the rooms, see Map::connectAndPlaceStairs(). Which generator digs a floor is drawn from the
+	table of the floor in data/floors.txt.
+*/
+class MapGenerator {
+   public:
+	enum Kind { BSP, CAVES, DRUNKARD_WALK, ROOMS_AND_MAZE, NB_KINDS };
+	static MapGenerator* create(Kind kind);
+	// Name used in data/floors.txt and on command lines
+	static const char* getName(Kind kind);
+	// NB_KINDS if there is no generator with that name
+	static Kind getKindByName(std::string_view name);
+
+	virtual ~MapGenerator() = default;
+	virtual void generate(Map& map) = 0;
+
+   protected:
+	// Layouts with no rooms of their own are cut into areas of about a room's size holding walkable tiles, recorded as
+	// rooms, so that spawning, wandering monsters and room effects have rooms to go by
+	static void addAreas(Map& map);
+};
+
+// Rooms in the leaves of a BSP tree, each joined to the one before by an L-shaped corridor
+class BspGenerator : public MapGenerator {
+   public:
+	void generate(Map& map) override;
+};
+
+/*
+	Cellular automaton caves. Tiles start as walls at random, then every step turns a tile into a wall when 5 or more
+	of the 9 tiles of the 3x3 block around it are walls and into floor otherwise. The largest cave is kept.
+*/
+class CaveGenerator : public MapGenerator {
+   public:
+	void generate(Map& map) override;
+	// One step of the automaton from walls into next, tiles off the board counting as walls. Rows are worked on a
+	// word of 64 tiles at a time: the 9 tiles of each block are added up bit by bit with carry-save adders, so the
+	// count of all 64 tiles of a word takes a few dozen word operations. next must cover the same rectangle.
+	static void step(const BitBoard& walls, BitBoard& next);
+};
+
+// A walker digs its way through the rock at random, starting over from a random dug tile every so often, until
+// enough of the floor is open
+class DrunkardWalkGenerator : public MapGenerator {
+   public:
+	void generate(Map& map) override;
+};
+
+// Rooms scattered without overlapping, a maze dug through the rock between them, doors opened so that everything is
+// connected, then the dead ends of the maze filled back in
+class RoomMazeGenerator : public MapGenerator {
+   public:
+	void generate(Map& map) override;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
 
 class Random {
@@ -23,3 +24,59 @@ class Random {
    private:
 	static unsigned getSystemClock();
 };
+
+// Weighted choice among N outcomes in constant time (Vose's alias method). Weights are integers, so the table is exact
+// and can be built at compile time.
+template <size_t N>
+class AliasTable {
+   public:
+	constexpr AliasTable() : total(0), thresholds{}, aliases{} {}
+	constexpr AliasTable(const int (&weights)[N]) : total(0), thresholds{}, aliases{} {
+		for (int weight : weights) total += weight;
+		// Every column holds total / N of weight: its own outcome below its threshold, its alias above
+		int scaled[N] = {}, small[N] = {}, large[N] = {};
+		int nbSmall = 0, nbLarge = 0;
+		for (size_t i = 0; i < N; i++) {
+			scaled[i] = weights[i] * (int)N;
+			aliases[i] = (uint8_t)i;
+			if (scaled[i] < total)
+				small[nbSmall++] = (int)i;
+			else
+				large[nbLarge++] = (int)i;
+		}
+		while (nbSmall > 0 && nbLarge > 0) {
+			int less = small[--nbSmall], more = large[--nbLarge];
+			thresholds[less] = scaled[less];
+			aliases[less] = (uint8_t)more;
+			scaled[more] -= total - scaled[less];
+			if (scaled[more] < total)
+				small[nbSmall++] = more;
+			else
+				large[nbLarge++] = more;
+		}
+		while (nbLarge > 0) thresholds[large[--nbLarge]] = total;
+		while (nbSmall > 0) thresholds[small[--nbSmall]] = total;
+	}
+
+	// Index of the outcome, drawn with probability weights[i] / sum of weights
+	int sample(Random& random) const {
+		int column = random.getBoundedInt(0, (int)N - 1);
+		return random.getBoundedInt(0, total - 1) < thresholds[column] ? column : aliases[column];
+	}
+
+	// Whether the table, read from a file, can only draw outcomes below nbOutcomes
+	bool isValid(int nbOutcomes = (int)N) const {
+		if (total <= 0) return false;
+		for (size_t i = 0; i < N; i++) {
+			if (thresholds[i] < 0 || thresholds[i] > total) return false;
+			if (thresholds[i] > 0 && (int)i >= nbOutcomes) return false;
+			if (thresholds[i] < total && aliases[i] >= nbOutcomes) return false;
+		}
+		return true;
+	}
+
+   private:
+	int total;
+	int thresholds[N];
+	uint8_t aliases[N];
+};
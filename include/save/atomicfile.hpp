@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Writing of whole files that are read back with MappedFile: saves, the content cache and the tileset atlas
+class AtomicFile {
+   public:
+	// Replace the file at path with data without ever leaving a partial file: write a temporary file, flush it to the
+	// disk, then rename it over path
+	static bool write(const std::filesystem::path& path, const uint8_t* data, size_t size);
+};
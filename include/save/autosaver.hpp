@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Saves the game in the background. snapshot() serializes the game into one of two buffers on the calling thread,
+// then a worker thread compresses it and atomically replaces the save file, so the game never waits for the disk.
+// A snapshot taken while the previous one is still being written replaces any snapshot still waiting its turn.
+class AutoSaver {
+   public:
+	struct Stats {
+		int snapshots = 0;
+		int writes = 0;
+		int failedWrites = 0;
+		// Time spent in snapshot(), i.e. taken from the game
+		double snapshotUsTotal = 0.0, snapshotUsMax = 0.0;
+		// Compression and disk time, on the worker thread
+		double writeUsTotal = 0.0, writeUsMax = 0.0;
+		size_t lastSaveBytes = 0, lastCompressedBytes = 0;
+	};
+
+	explicit AutoSaver(const std::filesystem::path& path);
+	// Writes the last snapshot before returning
+	~AutoSaver();
+
+	// Call at a turn boundary, from the thread that owns the engine
+	void snapshot();
+	// Wait until every snapshot taken so far is on disk
+	void flush();
+	Stats getStats();
+
+	// Disable copying and assignment
+	AutoSaver(const AutoSaver&) = delete;
+	AutoSaver& operator=(const AutoSaver&) = delete;
+
+   private:
+	void run();
+	void writeSnapshot(int index);
+
+	std::filesystem::path path;
+	std::vector<uint8_t> buffers[2];
+	std::vector<uint8_t> compressed;
+	int writing = -1;  // buffer owned by the worker, -1 if idle
+	int pending = -1;  // buffer waiting for the worker, -1 if none
+	bool isStopping = false;
+	Stats stats;
+
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable idle;
+#ifndef __EMSCRIPTEN__
+	std::thread worker;
+#endif
+};
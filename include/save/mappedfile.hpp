@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read-only memory mapping of a whole file. The contents stay valid until the object is destroyed, even if the file
+// is replaced on disk in the meantime.
+class MappedFile {
+   public:
+	explicit MappedFile(const std::filesystem::path& path);
+	~MappedFile();
+
+	bool isOpen() const { return contents != NULL; }
+	const uint8_t* data() const { return contents; }
+	size_t size() const { return length; }
+
+	// Disable copying and assignment
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+   private:
+	const uint8_t* contents;
+	size_t length;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
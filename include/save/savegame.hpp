@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "main.hpp"
+
+/*
+	Binary save file, little endian, every section 8 byte aligned:
+
+	FileHeader
+	SectionHeader[sectionCount]
+	sections...
+
+	A compressed save is a FileHeader with the COMPRESSED flag and no sections, followed by the size of the
+	uncompressed save as a uint64 and its zlib stream.
+
+	A floor snapshot is a compressed save with the FLOOR flag, holding one floor without the player, names or log.
+	Saves keep the snapshots of the floors the player left in FLOOR_DATA, each a range of it listed in FLOORS.
+
+	Sections are flat arrays of fixed size records, so loading is a bounds check followed by a single pass over each
+	table. Actors are referenced by their index in the ACTORS table, strings by their byte offset in the STRINGS blob.
+	World actors come first in engine order, followed by inventory items in inventory order.
+*/
+class SaveGame {
+   public:
+	static constexpr uint32_t VERSION = 3;
+	// FileHeader flags
+	static constexpr uint32_t COMPRESSED = 1;
+	static constexpr uint32_t FLOOR = 2;
+	// Largest uncompressed save read, anything bigger is a corrupted size. A save holds 3 bytes per tile of its map,
+	// its actors and the compressed snapshots of the floors left, each well under a byte per tile of the same map.
+	static constexpr uint64_t MAX_UNCOMPRESSED_SIZE = (uint64_t)Map::MAX_SIZE * Map::MAX_SIZE * 32;
+
+	// Serialize the running game of this thread's engine
+	static void write(std::vector<uint8_t>& out);
+	// Replace the running game with the one in data, compressed or not. Everything is validated first, so on failure
+	// the running game is left untouched and false is returned.
+	static bool read(const uint8_t* data, size_t size);
+
+	// Compress a save made by write(). Level goes from 1 (fastest) to 9 (smallest).
+	static bool compress(const std::vector<uint8_t>& save, std::vector<uint8_t>& out, int level = 1);
+
+	static bool save(const std::filesystem::path& path);
+	static bool load(const std::filesystem::path& path);
+
+	// Serialize and compress the current floor of this thread's engine: its map and every actor on it but the player
+	static bool writeFloor(std::vector<uint8_t>& out);
+	// Replace the current floor and its actors with a snapshot made by writeFloor(), keeping the player. Validated
+	// first like read(), so on failure nothing changes and false is returned.
+	static bool readFloor(const uint8_t* data, size_t size);
+
+	enum SectionId : uint32_t {
+		ENGINE,
+		WALKABLE,
+		TRANSPARENT,
+		EXPLORED,
+		ROOMS,
+		CORRIDORS,
+		STRINGS,
+		ACTORS,
+		DESTRUCTIBLES,
+		ATTACKERS,
+		AIS,
+		PICKABLES,
+		CONTAINERS,
+		NAMES,
+		LOG,
+		FLOORS,
+		FLOOR_DATA,
+		NB_SECTIONS
+	};
+
+	enum AiKind : uint32_t {
+		PLAYER_AI,
+		MONSTER_AI,
+		GREMLIN_AI,
+		ELF_AI,
+		LICH_AI,
+		DRAGON_AI,
+		CONFUSED_MONSTER_AI,
+		CONFUSED_PLAYER_AI,
+		FIRE_AI,
+		NATURE_AI,
+		BOT_AI,
+		NB_AI_KINDS
+	};
+
+	static constexpr uint32_t NO_INDEX = 0xFFFFFFFF;
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t endianTag;
+		uint32_t flags;
+		uint32_t sectionCount;
+		uint64_t fileSize;
+	};
+
+	struct SectionHeader {
+		uint32_t id;
+		uint32_t count;	 // number of records, bytes for STRINGS
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct EngineRecord {
+		int32_t level, monsterSpawnRate, fovRadius;
+		int32_t mapWidth, mapHeight;
+		uint32_t player, stairs, nature, upStairs;
+		uint8_t isMapRevealed, isEasyLayout, padding[2];
+	};
+
+	struct ActorRecord {
+		int32_t x, y;
+		uint32_t name;
+		uint32_t owner;	 // actor whose container holds this one, NO_INDEX if on the map
+		uint8_t ch, r, g, b;
+		uint8_t blocks, fovOnly, padding[2];
+	};
+
+	struct DestructibleRecord {
+		uint32_t actor;
+		uint32_t isPlayer;
+		float maxHp, hp, defense;
+		uint32_t corpseName, lastDamageSource;
+	};
+
+	struct AttackerRecord {
+		uint32_t actor;
+		float power;
+	};
+
+	// Temporary ais store the ai they replace as a separate record with actor NO_INDEX, written before them
+	struct AiRecord {
+		uint32_t actor;
+		uint32_t kind;
+		uint32_t oldAi;
+		uint32_t target;
+		int32_t values[5];
+	};
+
+	// Item components are rebuilt from the item name
+	struct PickableRecord {
+		uint32_t actor;
+	};
+
+	struct ContainerRecord {
+		uint32_t actor;
+		int32_t size;
+	};
+
+	struct NameRecord {
+		uint32_t itemName, defaultName, callName;
+		uint8_t ch;	 // 0 if the item has no default name
+		uint8_t flags;
+		uint8_t padding[2];
+	};
+
+	struct LogRecord {
+		uint32_t text;
+		uint8_t r, g, b, padding;
+		int32_t count;
+	};
+
+	// Snapshot of a floor left by the player, bytes [offset, offset + size) of FLOOR_DATA
+	struct FloorRecord {
+		int32_t level;
+		uint32_t padding;
+		uint64_t offset, size;
+	};
+
+   private:
+	struct Writer;
+	struct Reader;
+	// Serialize the running game, or only its current floor
+	static void write(std::vector<uint8_t>& out, bool isFloor);
+};
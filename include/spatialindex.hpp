@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+class Actor;
+
+/*
+	Actors bucketed by position in a uniform grid of CELL_SIZE tiles, so range queries only look at the cells the
+	range overlaps. Distances are compared squared. Actors outside the grid, like nature at (-1, -1), are kept in the
+	closest cell and filtered by their real position.
+
+	Indexed actors must move with Actor::moveTo, and remove themselves from their index when deleted.
+*/
+class SpatialIndex {
+   public:
+	static constexpr int CELL_SIZE = 8;
+
+	SpatialIndex(int width, int height);
+	~SpatialIndex();
+
+	// Remove every actor, and size the grid for a width * height map
+	void reset(int width, int height);
+	void insert(Actor* actor);
+	void remove(Actor* actor);
+	// Called by Actor::moveTo
+	void move(Actor* actor, int oldX, int oldY);
+	int size() const { return nbActors; }
+
+	// Calls function(actor) for every actor in the rectangle from (x1, y1) to (x2, y2), inclusive
+	template <typename Function>
+	void forEachInRect(int x1, int y1, int x2, int y2, Function function) const {
+		forEachEntryInRect(x1, y1, x2, y2, [&](const Entry& entry) { function(entry.actor); });
+	}
+
+	// Calls function(actor) for every actor at most radius away from (x, y)
+	template <typename Function>
+	void forEachInRadius(int x, int y, float radius, Function function) const {
+		int reach = (int)radius;
+		float radius2 = radius * radius;
+		forEachEntryInRect(x - reach, y - reach, x + reach, y + reach, [&](const Entry& entry) {
+			if (distance2(entry, x, y) <= radius2) function(entry.actor);
+		});
+	}
+
+	// Closest actor to (x, y) for which predicate(actor) holds, at most maxRadius away or anywhere if it is 0. Cells
+	// are searched in rings outward until no closer actor can remain. NULL if there is none.
+	template <typename Predicate>
+	Actor* findNearest(int x, int y, float maxRadius, Predicate predicate) const {
+		std::vector<Actor*> nearest;
+		findNearest(x, y, 1, maxRadius, predicate, nearest);
+		return nearest.empty() ? NULL : nearest[0];
+	}
+
+	// The k actors closest to (x, y) for which predicate(actor) holds, nearest first, as above
+	template <typename Predicate>
+	void findNearest(
+		int x, int y, int k, float maxRadius, Predicate predicate, std::vector<Actor*>& nearest) const {
+		nearest.clear();
+		if (k <= 0) return;
+		float maxRadius2 = maxRadius > 0.0F ? maxRadius * maxRadius : 1E30F;
+		std::vector<std::pair<int, Actor*>> found;	// (distance2, actor), sorted, at most k
+		int qx = cellX(x), qy = cellY(y);
+		int maxRing = std::max({qx, gridWidth - 1 - qx, qy, gridHeight - 1 - qy});
+		for (int ring = 0; ring <= maxRing; ring++) {
+			if (ring > 0) {
+				// Closest any tile of this ring can be
+				float bound = (float)((ring - 1) * CELL_SIZE + 1);
+				float bound2 = bound * bound;
+				if (bound2 > maxRadius2 || ((int)found.size() == k && found.back().first < bound2)) break;
+			}
+			for (int cy = qy - ring; cy <= qy + ring; cy++) {
+				if (cy < 0 || cy >= gridHeight) continue;
+				bool isEdgeRow = cy == qy - ring || cy == qy + ring;
+				for (int cx = qx - ring; cx <= qx + ring; cx += isEdgeRow || ring == 0 ? 1 : 2 * ring) {
+					if (cx < 0 || cx >= gridWidth) continue;
+					for (const Entry& entry : cells[cx + cy * gridWidth]) {
+						int d2 = distance2(entry, x, y);
+						if (d2 > maxRadius2 || ((int)found.size() == k && d2 >= found.back().first)) continue;
+						if (!predicate(entry.actor)) continue;
+						// Ties keep the actor found first
+						auto at = std::upper_bound(found.begin(), found.end(), d2, [](int d2, const auto& other) {
+							return d2 < other.first;
+						});
+						found.insert(at, {d2, entry.actor});
+						if ((int)found.size() > k) found.pop_back();
+					}
+				}
+			}
+		}
+		for (auto& [d2, actor] : found) nearest.push_back(actor);
+	}
+
+	// Disable copying and assignment, actors point to their index
+	SpatialIndex(const SpatialIndex&) = delete;
+	SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+   private:
+	struct Entry {
+		Actor* actor;
+		int x, y;  // copy of the actor position, so queries do not touch actors out of range
+	};
+
+	int gridWidth = 0, gridHeight = 0;
+	int nbActors = 0;
+	std::vector<std::vector<Entry>> cells;
+
+	int cellX(int x) const { return std::clamp(x, 0, gridWidth * CELL_SIZE - 1) / CELL_SIZE; }
+	int cellY(int y) const { return std::clamp(y, 0, gridHeight * CELL_SIZE - 1) / CELL_SIZE; }
+	std::vector<Entry>& cellAt(int x, int y) { return cells[cellX(x) + cellY(y) * gridWidth]; }
+	static int distance2(const Entry& entry, int x, int y) {
+		return (entry.x - x) * (entry.x - x) + (entry.y - y) * (entry.y - y);
+	}
+
+	template <typename Function>
+	void forEachEntryInRect(int x1, int y1, int x2, int y2, Function function) const {
+		if (x1 > x2 || y1 > y2) return;
+		int cx1 = cellX(x1), cx2 = cellX(x2), cy1 = cellY(y1), cy2 = cellY(y2);
+		for (int cy = cy1; cy <= cy2; cy++)
+			for (int cx = cx1; cx <= cx2; cx++)
+				for (const Entry& entry : cells[cx + cy * gridWidth])
+					if (x1 <= entry.x && entry.x <= x2 && y1 <= entry.y && entry.y <= y2) function(entry);
+	}
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <chrono>
+
+// Microseconds since start, for the timings the game logs and the headless tools report
+inline double elapsedUs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
@@ -10,17 +10,21 @@ Actor::Actor(int x, int y, char ch, const char* name, const TCOD_color_t& color)
 	  color(color),
 	  blocks(true),
 	  fovOnly(true),
+	  itemKind(Item::NO_KIND),
 	  attacker(NULL),
 	  destructible(NULL),
 	  ai(NULL),
 	  pickable(NULL),
-	  container(NULL) {}
+	  container(NULL),
+	  spatialIndex(NULL),
+	  drawOrder(0) {}
 
 Actor::~Actor() {
+	if (spatialIndex) spatialIndex->remove(this);
 	if (attacker) delete attacker;
 	if (destructible) delete destructible;
 	if (ai) delete ai;
-	if (pickable) delete pickable;
+	// pickable is shared by all items of a kind, see Item::Prototype
 	if (container) delete container;
 }
 
@@ -30,11 +34,30 @@ float Actor::getDistance(int cx, int cy) const {
 	return sqrtf(1.0f * (dx * dx + dy * dy));
 }
 
+void Actor::moveTo(int newX, int newY) {
+	int oldX = x, oldY = y;
+	x = newX;
+	y = newY;
+	if (!spatialIndex) return;
+	spatialIndex->move(this, oldX, oldY);
+	if (blocks && spatialIndex == &engine.spatialIndex) engine.freeTiles.moveBlocker(oldX, oldY, x, y);
+}
+
+void Actor::setBlocks(bool newBlocks) {
+	if (blocks != newBlocks && spatialIndex == &engine.spatialIndex) {
+		if (newBlocks)
+			engine.freeTiles.addBlocker(x, y);
+		else
+			engine.freeTiles.removeBlocker(x, y);
+	}
+	blocks = newBlocks;
+}
+
 // Draw actor tiles on the console according to the members: character ch and color col
-void Actor::render(tcod::Console& console) const {
-	if (console.in_bounds({x, y})) {
-		console.at({x, y}).ch = ch;
-		console[{x, y}].fg = color;
+void Actor::render(tcod::Console& console, int viewX, int viewY) const {
+	if (console.in_bounds({x - viewX, y - viewY})) {
+		console.at({x - viewX, y - viewY}).ch = ch;
+		console[{x - viewX, y - viewY}].fg = color;
 	}
 }
 
@@ -10,14 +10,20 @@ void PlayerAi::parseInput(
 	bool& isActionPickUp,
 	bool& isActionInventory,
 	bool& isActionControlsMenu,
+	bool& isActionHistory,
 	bool& isActionDescend,
-	bool& isActionRest) {
+	bool& isActionAscend,
+	bool& isActionRest,
+	bool& isActionPerfOverlay) {
 	dx = 0, dy = 0;
 	isActionPickUp = false;
 	isActionInventory = false;
 	isActionControlsMenu = false;
+	isActionHistory = false;
 	isActionDescend = false;
+	isActionAscend = false;
 	isActionRest = false;
+	isActionPerfOverlay = false;
 	switch (engine.lastKeyboardEvent.key) {
 		case SDLK_LEFT:
 		case SDLK_H:
@@ -76,10 +82,20 @@ void PlayerAi::parseInput(
 		case SDLK_QUESTION:
 			isActionControlsMenu = true;
 			break;
+		case SDLK_M:
+			isActionHistory = true;
+			break;
 		case SDLK_GREATER:
 		case SDLK_PERIOD:
 			isActionDescend = true;
 			break;
+		case SDLK_LESS:
+		case SDLK_COMMA:
+			isActionAscend = true;
+			break;
+		case SDLK_F3:
+			isActionPerfOverlay = true;
+			break;
 		default:
 			break;
 	}
@@ -95,9 +111,19 @@ void PlayerAi::update(Actor* owner) {
 		return;
 	}
 	int dx, dy;
-	bool isActionPickUp, isActionInventory, isActionControlsMenu, isActionDescend, isActionRest;
+	bool isActionPickUp, isActionInventory, isActionControlsMenu, isActionHistory, isActionDescend, isActionAscend,
+		isActionRest, isActionPerfOverlay;
 	PlayerAi::parseInput(
-		dx, dy, isActionPickUp, isActionInventory, isActionControlsMenu, isActionDescend, isActionRest);
+		dx,
+		dy,
+		isActionPickUp,
+		isActionInventory,
+		isActionControlsMenu,
+		isActionHistory,
+		isActionDescend,
+		isActionAscend,
+		isActionRest,
+		isActionPerfOverlay);
 	// If turn is spent update engine gamestatus to OTHER_ACTORS_TURN, else return to IDLE
 	bool isTurnSpent = false;
 	if (dx != 0 || dy != 0) {
@@ -130,6 +156,11 @@ void PlayerAi::update(Actor* owner) {
 	} else if (isActionControlsMenu) {
 		new ControlsMenu();
 		return;
+	} else if (isActionHistory) {
+		new HistoryMenu();
+		return;
+	} else if (isActionPerfOverlay) {
+		engine.perfOverlay.toggle();
 	} else if (isActionDescend) {
 		if (std::tie(owner->x, owner->y) == std::tie(engine.stairs->x, engine.stairs->y)) {
 			engine.nextLevel();
@@ -138,6 +169,14 @@ void PlayerAi::update(Actor* owner) {
 			engine.gui->message(
 				"There are no stairs here.\nDescend by pressing > while standing\ndirectly on top of stairs.");
 		}
+	} else if (isActionAscend) {
+		if (engine.upStairs && std::tie(owner->x, owner->y) == std::tie(engine.upStairs->x, engine.upStairs->y)) {
+			engine.previousLevel();
+			return;
+		} else {
+			engine.gui->message(
+				"There are no up stairs here.\nClimb by pressing < while standing\ndirectly on top of up stairs.");
+		}
 	} else if (isActionRest) {
 		isTurnSpent = true;
 	}
@@ -173,8 +212,7 @@ bool PlayerAi::moveOrAttack(Actor* owner, int targetx, int targety) {
 			}
 		}
 	}
-	owner->x = targetx;
-	owner->y = targety;
+	owner->moveTo(targetx, targety);
 	return true;
 }
 
@@ -204,19 +242,16 @@ void MonsterAi::update(Actor* owner) {
 		wanderingTurn--;
 		if (wanderingTurn <= 0 || owner->getDistance(targetX, targetY) <= 3.0F) {
 			wanderingTurn = WANDERING_CHANGE_TARGET_TURN;
-			int tries = 10;
-			do {
-				tries--;
-				targetX = Random::instance().getInt(0, engine.MAP_WIDTH);
-				targetY = Random::instance().getInt(0, engine.MAP_HEIGHT);
-			} while ((owner->getDistance(targetX, targetY) <= 35.0F || !engine.map->canWalk(targetX, targetY)) &&
-					 tries > 0);
-			if ((owner->getDistance(targetX, targetY) <= 35.0F || !engine.map->canWalk(targetX, targetY))) {
-				int roomIndex = Random::instance().getInt(0, (int)(engine.map->roomRecords.size()) - 1);
-				targetX = Random::instance().getInt(
-					engine.map->roomRecords[roomIndex][0], engine.map->roomRecords[roomIndex][2]);
-				targetY = Random::instance().getInt(
-					engine.map->roomRecords[roomIndex][1], engine.map->roomRecords[roomIndex][3]);
+			// Somewhere far away but not out of reach, or in a random room if the floor is too small for that
+			int range = Engine::ACTIVE_RANGE;
+			bool found = engine.freeTiles.sampleNear(owner->x, owner->y, range, targetX, targetY, [&](int x, int y) {
+				return (x - owner->x) * (x - owner->x) + (y - owner->y) * (y - owner->y) > 35 * 35;
+			});
+			if (!found) {
+				const Room& room =
+					engine.map->rooms[Random::instance().getInt(0, (int)engine.map->rooms.size() - 1)];
+				targetX = Random::instance().getInt(room.x1, room.x2);
+				targetY = Random::instance().getInt(room.y1, room.y2);
 			}
 		}
 		if (globalTurn > 200) {
@@ -238,8 +273,7 @@ void MonsterAi::moveOrAttack(Actor* owner, int dx, int dy) {
 		return;
 	}
 	if (engine.map->canWalk(cx, cy)) {
-		owner->x = cx;
-		owner->y = cy;
+		owner->moveTo(cx, cy);
 	}
 }
 
@@ -278,8 +312,7 @@ void ConfusedMonsterAi::update(Actor* owner) {
 		int destx = owner->x + dx;
 		int desty = owner->y + dy;
 		if (engine.map->canWalk(destx, desty)) {
-			owner->x = destx;
-			owner->y = desty;
+			owner->moveTo(destx, desty);
 		} else {
 			Actor* actor = engine.getActor(destx, desty);
 			if (actor) {
@@ -303,9 +336,19 @@ void ConfusedPlayerAi::update(Actor* owner) {
 		return;
 	}
 	int dx, dy;
-	bool isActionPickUp, isActionInventory, isActionControlsMenu, isActionDescend, isActionRest;
+	bool isActionPickUp, isActionInventory, isActionControlsMenu, isActionHistory, isActionDescend, isActionAscend,
+		isActionRest, isActionPerfOverlay;
 	PlayerAi::parseInput(
-		dx, dy, isActionPickUp, isActionInventory, isActionControlsMenu, isActionDescend, isActionRest);
+		dx,
+		dy,
+		isActionPickUp,
+		isActionInventory,
+		isActionControlsMenu,
+		isActionHistory,
+		isActionDescend,
+		isActionAscend,
+		isActionRest,
+		isActionPerfOverlay);
 	// If turn is spent update engine gamestatus to OTHER_ACTORS_TURN, else return to IDLE
 	bool isTurnSpent = false;
 	if (dx != 0 || dy != 0) {
@@ -345,6 +388,11 @@ void ConfusedPlayerAi::update(Actor* owner) {
 	} else if (isActionControlsMenu) {
 		new ControlsMenu();
 		return;
+	} else if (isActionHistory) {
+		new HistoryMenu();
+		return;
+	} else if (isActionPerfOverlay) {
+		engine.perfOverlay.toggle();
 	} else if (isActionDescend) {
 		if (std::tie(owner->x, owner->y) == std::tie(engine.stairs->x, engine.stairs->y)) {
 			engine.nextLevel();
@@ -356,6 +404,17 @@ void ConfusedPlayerAi::update(Actor* owner) {
 			engine.gui->message(
 				"There are no stairs here.\nDescend by pressing > while standing\ndirectly on top of stairs.");
 		}
+	} else if (isActionAscend) {
+		if (engine.upStairs && std::tie(owner->x, owner->y) == std::tie(engine.upStairs->x, engine.upStairs->y)) {
+			engine.previousLevel();
+			// Although turn not spent, pass confusion timer
+			engine.gameStatus = Engine::IDLE;
+			TemporaryAi::update(owner);
+			return;
+		} else {
+			engine.gui->message(
+				"There are no up stairs here.\nClimb by pressing < while standing\ndirectly on top of up stairs.");
+		}
 	} else if (isActionRest) {
 		isTurnSpent = true;
 	}
@@ -430,16 +489,15 @@ void ElfAi::update(Actor* owner) {
 		return;
 	}
 	if (Random::instance().getBool(0.5)) {
-		Actor* healTarget = NULL;
-		for (auto actor : engine.actors)
-			if (actor != engine.player && actor != owner && actor->getDistance(owner->x, owner->y) <= 5.0F &&
-				actor->destructible && !actor->destructible->isDead() &&
-				actor->destructible->hp < actor->destructible->maxHp) {
-				healTarget = actor;
-				break;
-			}
+		// Heal the closest wounded ally
+		Actor* healTarget = engine.spatialIndex.findNearest(owner->x, owner->y, 5.0F, [&](Actor* actor) {
+			return actor != engine.player && actor != owner && actor->destructible && !actor->destructible->isDead() &&
+				   actor->destructible->hp < actor->destructible->maxHp;
+		});
 		if (healTarget != NULL) {
-			HealthEffect effect(30.0F, 0.0F, "The elf casts a healing spell!\n%s recovers %g HP.");
+			// Events are one line each, so the announcement is a line of its own
+			engine.gui->message("The elf casts a healing spell!");
+			HealthEffect effect(30.0F, 0.0F, "%s recovers %g HP.");
 			effect.applyTo(healTarget);
 		}
 	} else
@@ -471,3 +529,144 @@ void DragonAi::update(Actor* owner) {
 	} else
 		MonsterAi::update(owner);
 }
+
+void BotAi::update(Actor* owner) {
+	if (owner->destructible && owner->destructible->isDead()) {
+		return;
+	}
+	// Every decision of the bot spends its turn
+	engine.gameStatus = Engine::OTHER_ACTORS_TURN;
+	if (useItems(owner) || fightOrFlee(owner)) return;
+
+	Map* map = engine.map;
+	Actor* stairs = engine.stairs;
+	bool knowsStairs = map->isMapRevealed || map->isExplored(stairs->x, stairs->y);
+	if (knowsStairs && owner->x == stairs->x && owner->y == stairs->y) {
+		engine.nextLevel();
+		return;
+	}
+	bool canCarry = owner->container && (owner->container->size == 0 ||
+										 (int)owner->container->inventory.size() < owner->container->size);
+	// Items on seen tiles, so goals of the search below are single bit tests
+	const BitBoard& fov = map->getFov();
+	visibleItems.reset(fov.getX(), fov.getY(), fov.getWidth(), fov.getHeight());
+	if (canCarry) {
+		int x2 = fov.getX() + fov.getWidth() - 1, y2 = fov.getY() + fov.getHeight() - 1;
+		engine.spatialIndex.forEachInRect(fov.getX(), fov.getY(), x2, y2, [&](Actor* actor) {
+			if (actor->pickable) visibleItems.set(actor->x, actor->y);
+		});
+		visibleItems &= fov;
+	}
+	if (visibleItems.any() && stepTowards(owner, [&](int x, int y) { return visibleItems.get(x, y); })) return;
+	if (knowsStairs &&
+		stepTowards(owner, [&](int x, int y) { return x == stairs->x && y == stairs->y; }))
+		return;
+	if (canExplore(owner) && stepTowards(owner, [&](int x, int y) { return !map->isExplored(x, y); })) return;
+	// Nothing left to do, rest for a turn
+}
+
+// Flood fill the walkable layer from the bot and remove the explored layer from it. Once the floor is explored this
+// saves searching every reachable tile each turn.
+bool BotAi::canExplore(Actor* owner) {
+	Map* map = engine.map;
+	reachable.reset(0, 0, map->width, map->height);
+	tiles.reset(0, 0, map->width, map->height);
+	map->getTiles(Map::TILE_WALKABLE, tiles);
+	reachable.set(owner->x, owner->y);
+	reachable.floodFill(tiles);
+	map->getTiles(Map::TILE_EXPLORED, tiles);
+	return reachable.subtract(tiles).any();
+}
+
+// Drink healing when low, and stat boosting potions or mapping scrolls right away. Returns if the turn is spent.
+bool BotAi::useItems(Actor* owner) {
+	if (!owner->container) return false;
+	bool isLow = owner->destructible->hp < owner->destructible->maxHp * 0.4F;
+	for (auto itemActor : owner->container->inventory) {
+		std::string_view name = itemActor->name;
+		bool wanted = (isLow && name == "Potion of Full Healing") || name == "Potion of Strength" ||
+					  name == "Potion of Protection" || (name == "Scroll of Mapping" && !engine.map->isMapRevealed);
+		if (wanted) {
+			itemUses[itemActor->name]++;
+			engine.nameTracker->identifyItem(itemActor);
+			itemActor->pickable->use(itemActor, owner);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Attack the weakest adjacent monster, or step away from them when about to die. Returns if the turn is spent.
+bool BotAi::fightOrFlee(Actor* owner) {
+	Actor* weakest = NULL;
+	std::vector<Actor*> adjacent;
+	for (int dx = -1; dx <= 1; dx++)
+		for (int dy = -1; dy <= 1; dy++) {
+			if (dx == 0 && dy == 0) continue;
+			Actor* actor = engine.getActor(owner->x + dx, owner->y + dy);
+			if (actor && actor != owner) {
+				adjacent.push_back(actor);
+				if (!weakest || actor->destructible->hp < weakest->destructible->hp) weakest = actor;
+			}
+		}
+	if (!weakest) return false;
+	if (owner->destructible->hp < owner->destructible->maxHp * 0.25F) {
+		// Flee to the free neighbour farthest away from every adjacent monster
+		int bestDx = 0, bestDy = 0, bestDistance = 2;
+		for (int dx = -1; dx <= 1; dx++)
+			for (int dy = -1; dy <= 1; dy++) {
+				int x = owner->x + dx, y = owner->y + dy;
+				if ((dx == 0 && dy == 0) || !engine.map->canWalk(x, y)) continue;
+				int closest = 1000000;
+				for (auto monster : adjacent)
+					closest = std::min(closest, (monster->x - x) * (monster->x - x) + (monster->y - y) * (monster->y - y));
+				if (closest > bestDistance) {
+					bestDistance = closest;
+					bestDx = dx;
+					bestDy = dy;
+				}
+			}
+		if (bestDx != 0 || bestDy != 0) {
+			PlayerAi::moveOrAttack(owner, owner->x + bestDx, owner->y + bestDy);
+			engine.map->computeFov();
+			return true;
+		}
+	}
+	PlayerAi::moveOrAttack(owner, weakest->x, weakest->y);
+	return true;
+}
+
+// Breadth first search over walkable tiles, then take the first step to the closest goal tile. Returns false if no
+// goal tile is reachable.
+template <typename Goal>
+bool BotAi::stepTowards(Actor* owner, Goal isGoal) {
+	Map* map = engine.map;
+	int width = map->width, height = map->height;
+	parents.assign(width * height, -1);
+	std::vector<int> queue;
+	queue.reserve(width * height);
+	int start = owner->x + owner->y * width;
+	parents[start] = start;
+	queue.push_back(start);
+	for (size_t head = 0; head < queue.size(); head++) {
+		int index = queue[head];
+		int x = index % width, y = index / width;
+		if (index != start && isGoal(x, y)) {
+			// Walk back to the tile next to the start
+			while (parents[index] != start) index = parents[index];
+			if (!PlayerAi::moveOrAttack(owner, index % width, index / width)) return false;
+			engine.map->computeFov();
+			return true;
+		}
+		for (int dx = -1; dx <= 1; dx++)
+			for (int dy = -1; dy <= 1; dy++) {
+				int nx = x + dx, ny = y + dy;
+				if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+				int next = nx + ny * width;
+				if (parents[next] != -1 || !map->isWalkable(nx, ny)) continue;
+				parents[next] = index;
+				queue.push_back(next);
+			}
+	}
+	return false;
+}
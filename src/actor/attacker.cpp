@@ -11,38 +11,23 @@ Attacker::Attacker(float power) : power(power) {}
 void Attacker::attack(Actor* owner, Actor* target) {
 	if (target->destructible && !target->destructible->isDead()) {
 		if (power - target->destructible->defense > 0) {
-			engine.gui->message(
-				tcod::stringf(
-					"%s attack%s %s for %g HP.",
-					owner == engine.player ? "You" : owner->name,
-					owner == engine.player ? "" : "s",
-					target == engine.player ? "you" : target->name,
-					power - target->destructible->defense),
-				target == engine.player ? RED : GOLD);
+			float damage = power - target->destructible->defense;
+			engine.gui->event(Gui::ATTACK, owner, target, damage, target == engine.player ? RED : GOLD);
 		} else {
-			engine.gui->message(
-				tcod::stringf(
-					"%s attack%s %s but it has no effect!",
-					owner == engine.player ? "You" : owner->name,
-					owner == engine.player ? "" : "s",
-					target == engine.player ? "you" : target->name));
+			engine.gui->event(Gui::ATTACK_NO_EFFECT, owner, target);
 		}
+		target->destructible->lastDamageSource = owner->name;
 		target->destructible->takeDamage(target, power);
 	} else {
-		engine.gui->message(tcod::stringf("%s attacks %s in vain.", owner->name, target->name));
+		engine.gui->event(Gui::ATTACK_IN_VAIN, owner, target);
 	}
 }
 
 void Attacker::burn(Actor* owner, Actor* target, float damageOverride) {
 	if (damageOverride == 0.0F) damageOverride = power;
 	if (target->destructible && !target->destructible->isDead()) {
-		engine.gui->message(
-			tcod::stringf(
-				"%s get%s burned for %g HP.",
-				target == engine.player ? "You" : target->name,
-				target == engine.player ? "" : "s",
-				damageOverride),
-			target == engine.player ? RED : GOLD);
+		engine.gui->event(Gui::BURN, target, NULL, damageOverride, target == engine.player ? RED : GOLD);
+		target->destructible->lastDamageSource = owner->name;
 		target->destructible->takeTrueDamage(target, damageOverride);
 	}
 }
@@ -55,17 +40,9 @@ void Attacker::changePower(Actor* owner, float deltaPower) {
 		owner->attacker->power = std::max(owner->attacker->power, 1.0F);
 		float realChanged = owner->attacker->power - originalPower;
 		if (realChanged > 0) {
-			engine.gui->message(
-				tcod::stringf(
-					"%s become%s more powerful!",
-					owner == engine.player ? "You" : owner->name,
-					owner == engine.player ? "" : "s"));
+			engine.gui->event(Gui::POWER_UP, owner);
 		} else if (realChanged < 0) {
-			engine.gui->message(
-				tcod::stringf(
-					"%s become%s weaker!",
-					owner == engine.player ? "You" : owner->name,
-					owner == engine.player ? "" : "s"));
+			engine.gui->event(Gui::POWER_DOWN, owner);
 		}
 	}
 }
@@ -6,7 +6,7 @@ static constexpr auto RED = tcod::ColorRGB{255, 0, 0};
 static constexpr auto LIGHT_GREY = tcod::ColorRGB{159, 159, 159};
 
 Destructible::Destructible(float maxHp, float defense, const char* corpseName)
-	: maxHp(maxHp), hp(maxHp), defense(defense), corpseName(corpseName) {}
+	: maxHp(maxHp), hp(maxHp), defense(defense), corpseName(corpseName), lastDamageSource(NULL) {}
 
 // Have an owner take damage (subject to defense), calling die() if necessary
 float Destructible::takeDamage(Actor* owner, float damage) {
@@ -40,7 +40,7 @@ void Destructible::die(Actor* owner) {
 	owner->ch = '%';
 	owner->color = tcod::ColorRGB{191, 0, 0};
 	owner->name = corpseName;
-	owner->blocks = false;
+	owner->setBlocks(false);
 	// Make sure corpses are drawn before living actors
 	engine.sendToBack(owner);
 }
@@ -72,7 +72,7 @@ PlayerDestructible::PlayerDestructible(float maxHp, float defense, const char* c
 
 void MonsterDestructible::die(Actor* owner) {
 	// Transform it into a nasty corpse! It doesn't block, can't be attacked and doesn't move
-	engine.gui->message(tcod::stringf("%s is dead.", owner->name));
+	engine.gui->event(Gui::DEATH, owner);
 	Destructible::die(owner);
 }
 
@@ -24,28 +24,22 @@ HealthEffect::HealthEffect(float amount, float maxAmountOnFull, const char* mess
 
 bool HealthEffect::applyTo(Actor* actor) {
 	if (!actor->destructible) return false;
+	const char* name = actor == engine.player ? "You" : actor->name;
 	if (amount > 0 || (amount >= 0 && maxAmountOnFull > 0)) {
 		float pointsHealed = actor->destructible->heal(amount);
 		if (pointsHealed > 0) {
-			if (message) {
-				engine.gui->message(
-					tcod::stringf(message, actor == engine.player ? "You" : actor->name, pointsHealed), LIGHT_GREY);
-			}
+			if (message) engine.gui->event(message, name, pointsHealed, LIGHT_GREY);
 			return true;
 		} else {
 			float deltaDefense = 0.0F;
 			if (maxAmountOnFull >= 24.0F) deltaDefense = 1.0F;
 			pointsHealed = actor->destructible->changeStats(maxAmountOnFull, deltaDefense);
-			engine.gui->message(
-				tcod::stringf(message, actor == engine.player ? "You" : actor->name, pointsHealed), LIGHT_GREY);
+			if (message) engine.gui->event(message, name, pointsHealed, LIGHT_GREY);
 			return true;
 		}
 	} else {
 		if (message && -amount - actor->destructible->defense > 0) {
-			engine.gui->message(
-				tcod::stringf(
-					message, actor == engine.player ? "You" : actor->name, -amount - actor->destructible->defense),
-				LIGHT_GREY);
+			engine.gui->event(message, name, -amount - actor->destructible->defense, LIGHT_GREY);
 		}
 		if (actor->destructible->takeDamage(actor, -amount) > 0) {
 			return true;
@@ -58,12 +52,12 @@ AiChangeEffect::AiChangeEffect(TemporaryAi* newAi, const char* message) : newAi(
 
 bool AiChangeEffect::applyTo(Actor* actor) {
 	if (typeid(*(actor->ai)).name() == typeid(*(newAi)).name()) {
-		engine.gui->message(tcod::stringf(message, actor->name), LIGHT_GREY);
+		if (message) engine.gui->event(message, actor->name, 0.0F, LIGHT_GREY);
 		return true;
 	}
 	newAi->applyTo(actor);
 	if (message) {
-		engine.gui->message(tcod::stringf(message, actor->name), LIGHT_GREY);
+		engine.gui->event(message, actor->name, 0.0F, LIGHT_GREY);
 	}
 	return true;
 }
@@ -98,7 +92,7 @@ bool SetOnFireEffect::applyTo(Actor* actor) {
 		}
 	if (fireActor == NULL) {
 		fireActor = new Actor(-1, -1, 'F', "fire", RED);
-		engine.actors.push_back(fireActor);
+		engine.addActor(fireActor);
 	}
 	// Override its ai
 	if (fireActor->ai) delete fireActor->ai;
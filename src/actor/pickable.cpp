@@ -28,10 +28,9 @@ bool Pickable::pick(Actor* owner, Actor* wearer) {
 void Pickable::drop(Actor* owner, Actor* wearer) {
 	if (wearer->container) {
 		wearer->container->remove(owner);
-		engine.actors.push_back(owner);
+		owner->moveTo(wearer->x, wearer->y);
+		engine.addActor(owner);
 		engine.sendToBack(owner);
-		owner->x = wearer->x;
-		owner->y = wearer->y;
 		if (wearer == engine.player)
 			engine.gui->message(tcod::stringf("You drop a %s.", engine.nameTracker->getDisplayName(owner)), LIGHT_GREY);
 		else
@@ -43,10 +42,9 @@ void Pickable::drop(Actor* owner, Actor* wearer) {
 void Pickable::swap(Actor* owner, Actor* groundItem, Actor* wearer) {
 	if (wearer->container) {
 		wearer->container->remove(owner);
-		engine.actors.push_back(owner);
+		owner->moveTo(wearer->x, wearer->y);
+		engine.addActor(owner);
 		engine.sendToBack(owner);
-		owner->x = wearer->x;
-		owner->y = wearer->y;
 		if (wearer == engine.player)
 			engine.gui->message(
 				tcod::stringf("You swap %s\nwith the item on the ground.", engine.nameTracker->getDisplayName(owner)),
@@ -100,8 +98,7 @@ Menu* ScrollOfTeleportationPickable::tilePickCallback(
 	Actor* owner, Actor* wearer, bool isCancelled, int x, int y, Menu* callbackMenu) {
 	auto [cx, cy] = engine.map->findSpotsNear(x, y);
 	if (cx != -1 && cy != -1) {
-		wearer->x = cx;
-		wearer->y = cy;
+		wearer->moveTo(cx, cy);
 		if (wearer == engine.player) engine.map->computeFov();
 		engine.gui->message("You teleported!", LIGHT_GREEN);
 	} else {
@@ -26,12 +26,9 @@ Menu* TargetSelector::selectTargets(Actor* owner, Actor* wearer, Menu* inventory
 			return new TilePickMenu(this, owner, wearer, true, TilePickMenu::IN_LINE_OF_SIGHT);
 		} break;
 		case WEARER_RANGE: {
-			for (auto actor : engine.actors) {
-				if (actor != wearer && actor->destructible && !actor->destructible->isDead() &&
-					actor->getDistance(wearer->x, wearer->y) <= range) {
-					list.push_back(actor);
-				}
-			}
+			engine.spatialIndex.forEachInRadius(wearer->x, wearer->y, range, [&](Actor* actor) {
+				if (actor != wearer && actor->destructible && !actor->destructible->isDead()) list.push_back(actor);
+			});
 			if (list.empty()) engine.gui->message("No enemies nearby.", LIGHT_GREY);
 			owner->pickable->applyEffects(owner, wearer, false, list);
 			return NULL;
@@ -58,16 +55,14 @@ Menu* TargetSelector::selectTargets(Actor* owner, Actor* wearer, Menu* inventory
 			// room or around, excluding wearer
 			int x1, y1, x2, y2, cx, cy;
 			cx = wearer->x, cy = wearer->y;
-			bool foundRoom = false;
-			for (auto [roomx1, roomy1, roomx2, roomy2] : engine.map->roomRecords) {
-				if (roomx1 <= cx && cx <= roomx2 && roomy1 <= cy && cy <= roomy2) {
-					foundRoom = true;
-					x1 = roomx1;
-					y1 = roomy1;
-					x2 = roomx2;
-					y2 = roomy2;
-					break;
-				}
+			uint16_t room = engine.map->getRoomAt(cx, cy);
+			bool foundRoom = room < engine.map->rooms.size();
+			if (foundRoom) {
+				const Room& bounds = engine.map->rooms[room];
+				x1 = bounds.x1;
+				y1 = bounds.y1;
+				x2 = bounds.x2;
+				y2 = bounds.y2;
 			}
 			if (!foundRoom) {
 				x1 = cx - 1;
@@ -80,11 +75,9 @@ Menu* TargetSelector::selectTargets(Actor* owner, Actor* wearer, Menu* inventory
 				x2++;
 				y2++;
 			}
-			for (auto actor : engine.actors)
-				if (actor != wearer && actor->destructible && !actor->destructible->isDead() &&
-					(x1 <= actor->x && actor->x <= x2 && y1 <= actor->y && actor->y <= y2)) {
-					list.push_back(actor);
-				}
+			engine.spatialIndex.forEachInRect(x1, y1, x2, y2, [&](Actor* actor) {
+				if (actor != wearer && actor->destructible && !actor->destructible->isDead()) list.push_back(actor);
+			});
 			if (list.empty()) engine.gui->message("No enemies nearby.", LIGHT_GREY);
 			owner->pickable->applyEffects(owner, wearer, false, list);
 		} break;
@@ -114,11 +107,9 @@ Menu* TargetSelector::tilePickCallback(
 			return NULL;
 		} break;
 		case SELECTED_RANGE: {
-			for (auto actor : engine.actors) {
-				if (actor->destructible && !actor->destructible->isDead() && actor->getDistance(x, y) <= range) {
-					list.push_back(actor);
-				}
-			}
+			engine.spatialIndex.forEachInRadius(x, y, range, [&](Actor* actor) {
+				if (actor->destructible && !actor->destructible->isDead()) list.push_back(actor);
+			});
 			if (list.empty()) engine.gui->message("No enemies close enough to the selected center.", LIGHT_GREY);
 			owner->pickable->applyEffects(owner, wearer, false, list);
 			return NULL;
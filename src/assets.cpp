@@ -0,0 +1,142 @@
+#include "assets.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "main.hpp"
+
+static constexpr char ATLAS_MAGIC[8] = "UWATLAS";
+
+const std::filesystem::path& Assets::getDataDir() {
+	static const std::filesystem::path dataDir = [] {
+		if (const char* basePath = SDL_GetBasePath()) {
+			auto path = std::filesystem::path(basePath) / "data";
+			if (std::filesystem::is_directory(path)) return path;
+		}
+		auto current = std::filesystem::current_path();
+		while (!std::filesystem::exists(current / "data")) {
+			auto parent = current.parent_path();
+			if (parent == current) {
+				throw std::runtime_error("Could not find the data directory.");
+			}
+			current = parent;
+		}
+		return current / "data";
+	}();
+	return dataDir;
+}
+
+#ifdef EMBED_DATA
+static const Assets::EmbeddedFile* findEmbeddedFile(std::string_view name) {
+	for (int i = 0; i < Assets::NB_EMBEDDED_FILES; i++)
+		if (name == Assets::EMBEDDED_FILES[i].name) return &Assets::EMBEDDED_FILES[i];
+	return NULL;
+}
+#endif
+
+bool Assets::readFile(const char* name, std::string& contents) {
+#ifdef EMBED_DATA
+	const EmbeddedFile* file = findEmbeddedFile(name);
+	if (!file) return false;
+	contents.assign(reinterpret_cast<const char*>(file->data), file->size);
+	return true;
+#else
+	std::ifstream file(getDataDir() / name, std::ios::binary);
+	if (!file) return false;
+	std::ostringstream stream;
+	stream << file.rdbuf();
+	contents = stream.str();
+	return true;
+#endif
+}
+
+uint64_t Assets::hash(std::string_view bytes, uint64_t hash) {
+	for (char byte : bytes) hash = (hash ^ (uint8_t)byte) * 1099511628211ULL;
+	return hash;
+}
+
+// Tileset from an atlas file made by saveAtlas, NULL if it is missing, outdated or invalid
+static tcod::TilesetPtr loadAtlas(const std::filesystem::path& path, uint64_t sourceStamp) {
+	MappedFile file(path);
+	Assets::AtlasHeader header;
+	if (!file.isOpen() || file.size() < sizeof(header)) return NULL;
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (std::memcmp(header.magic, ATLAS_MAGIC, sizeof(ATLAS_MAGIC)) != 0 || header.version != Assets::ATLAS_VERSION ||
+		header.sourceStamp != sourceStamp || header.tileWidth <= 0 || header.tileHeight <= 0)
+		return NULL;
+	size_t tileLength = (size_t)header.tileWidth * header.tileHeight;
+	size_t pixelsSize = header.nbTiles * tileLength * sizeof(TCOD_ColorRGBA);
+	if (file.size() != sizeof(header) + pixelsSize + header.nbCodepoints * sizeof(int32_t)) return NULL;
+
+	// Copy tile indices out rather than alias the mapping
+	const auto* pixels = reinterpret_cast<const TCOD_ColorRGBA*>(file.data() + sizeof(header));
+	std::vector<int32_t> tiles(header.nbCodepoints);
+	std::memcpy(tiles.data(), file.data() + sizeof(header) + pixelsSize, tiles.size() * sizeof(int32_t));
+	tcod::TilesetPtr tileset{TCOD_tileset_new(header.tileWidth, header.tileHeight)};
+	if (!tileset) return NULL;
+	for (int codepoint = 0; codepoint < (int)tiles.size(); codepoint++) {
+		int tile = tiles[codepoint];
+		if (tile <= 0) continue;
+		if ((uint32_t)tile >= header.nbTiles) return NULL;
+		if (TCOD_tileset_set_tile_(tileset.get(), codepoint, pixels + tile * tileLength) < 0) return NULL;
+	}
+	return tileset;
+}
+
+static void saveAtlas(const std::filesystem::path& path, const TCOD_Tileset& tileset, uint64_t sourceStamp) {
+	Assets::AtlasHeader header = {
+		{},
+		Assets::ATLAS_VERSION,
+		tileset.tile_width,
+		tileset.tile_height,
+		(uint32_t)tileset.tiles_count,
+		(uint32_t)tileset.character_map_length,
+		0,
+		sourceStamp};
+	std::memcpy(header.magic, ATLAS_MAGIC, sizeof(ATLAS_MAGIC));
+	size_t pixelsSize = (size_t)tileset.tiles_count * tileset.tile_length * sizeof(TCOD_ColorRGBA);
+	size_t tilesSize = (size_t)tileset.character_map_length * sizeof(int32_t);
+	std::vector<uint8_t> atlas(sizeof(header) + pixelsSize + tilesSize);
+	std::memcpy(atlas.data(), &header, sizeof(header));
+	std::memcpy(atlas.data() + sizeof(header), tileset.pixels, pixelsSize);
+	std::memcpy(atlas.data() + sizeof(header) + pixelsSize, tileset.character_map, tilesSize);
+	// Without an atlas the image is only decoded again next time
+	AtomicFile::write(path, atlas.data(), atlas.size());
+}
+
+tcod::TilesetPtr Assets::loadTilesheet(
+	const char* name, const std::array<int, 2>& columnsRows, std::span<const int> charmap, bool& isFromAtlas) {
+	std::string atlasName = std::string(name) + ".atlas";
+#ifdef EMBED_DATA
+	const EmbeddedFile* image = findEmbeddedFile(name);
+	if (!image) throw std::runtime_error(std::string("Could not find data/") + name);
+	uint64_t sourceStamp = hash({reinterpret_cast<const char*>(image->data), image->size});
+	std::filesystem::path atlasPath = Engine::getPrefPath(atlasName.c_str());
+#else
+	std::filesystem::path imagePath = getDataDir() / name;
+	std::error_code error;
+	uint64_t sourceStamp = (uint64_t)std::filesystem::last_write_time(imagePath, error).time_since_epoch().count();
+	std::filesystem::path atlasPath = getDataDir() / atlasName;
+#endif
+
+	isFromAtlas = false;
+	if (!atlasPath.empty()) {
+		if (auto tileset = loadAtlas(atlasPath, sourceStamp)) {
+			isFromAtlas = true;
+			return tileset;
+		}
+	}
+
+#ifdef EMBED_DATA
+	tcod::TilesetPtr tileset{TCOD_tileset_load_mem(
+		image->size, image->data, columnsRows[0], columnsRows[1], (int)charmap.size(), charmap.data())};
+	if (!tileset) throw std::runtime_error(std::string("Could not decode data/") + name);
+#else
+	tcod::TilesetPtr tileset = tcod::load_tilesheet(imagePath, columnsRows, charmap);
+#endif
+	if (!atlasPath.empty()) saveAtlas(atlasPath, *tileset, sourceStamp);
+	return tileset;
+}
@@ -0,0 +1,134 @@
+#include "bitboard.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void BitBoard::reset(int x, int y, int width, int height) {
+	x0 = x;
+	y0 = y;
+	this->width = std::max(0, width);
+	this->height = std::max(0, height);
+	nbWords = (this->width + 63) / 64;
+	lastWordMask = this->width % 64 ? (uint64_t(1) << (this->width % 64)) - 1 : ~uint64_t(0);
+	words.assign((size_t)nbWords * this->height, 0);
+}
+
+void BitBoard::setRow(int y, int x1, int x2) {
+	x1 = std::max(x1, x0) - x0;
+	x2 = std::min(x2, x0 + width - 1) - x0;
+	if (y < y0 || y >= y0 + height || x1 > x2) return;
+	uint64_t* row = rowWords(y - y0);
+	for (int w = x1 / 64; w <= x2 / 64; w++) {
+		// Bits from x1 to x2 that fall in this word
+		int first = std::max(x1 - w * 64, 0), last = std::min(x2 - w * 64, 63);
+		uint64_t upTo = last == 63 ? ~uint64_t(0) : (uint64_t(1) << (last + 1)) - 1;
+		row[w] |= upTo & ~((uint64_t(1) << first) - 1);
+	}
+}
+
+void BitBoard::setDisc(int x, int y, float radius) {
+	if (radius < 0.0F) return;
+	float radius2 = radius * radius;
+	for (int dy = -(int)radius; dy <= (int)radius; dy++) {
+		// Widest dx with dx * dx + dy * dy <= radius2
+		float left = radius2 - (float)(dy * dy);
+		if (left < 0.0F) continue;
+		int half = (int)std::sqrt(left);
+		while ((float)((half + 1) * (half + 1)) <= left) half++;
+		while (half > 0 && (float)(half * half) > left) half--;
+		setRow(y + dy, x - half, x + half);
+	}
+}
+
+bool BitBoard::any() const {
+	return std::any_of(words.begin(), words.end(), [](uint64_t word) { return word != 0; });
+}
+
+int BitBoard::count() const {
+	int total = 0;
+	for (uint64_t word : words) total += std::popcount(word);
+	return total;
+}
+
+BitBoard& BitBoard::operator&=(const BitBoard& other) {
+	assert(isSameRect(other));
+	for (size_t i = 0; i < words.size(); i++) words[i] &= other.words[i];
+	return *this;
+}
+
+BitBoard& BitBoard::operator|=(const BitBoard& other) {
+	assert(isSameRect(other));
+	for (size_t i = 0; i < words.size(); i++) words[i] |= other.words[i];
+	return *this;
+}
+
+BitBoard& BitBoard::subtract(const BitBoard& other) {
+	assert(isSameRect(other));
+	for (size_t i = 0; i < words.size(); i++) words[i] &= ~other.words[i];
+	return *this;
+}
+
+void BitBoard::spreadRow(const uint64_t* row, uint64_t* out) const {
+	for (int w = 0; w < nbWords; w++) {
+		// Bits crossing into the next or previous word come from the last or first bit of the neighbour word
+		uint64_t fromLeft = w > 0 ? row[w - 1] >> 63 : 0;
+		uint64_t fromRight = w + 1 < nbWords ? row[w + 1] << 63 : 0;
+		out[w] = row[w] | (row[w] << 1) | fromLeft | (row[w] >> 1) | fromRight;
+	}
+	if (nbWords) out[nbWords - 1] &= lastWordMask;
+}
+
+// Tiles of run connected to the tiles of seeds, toward higher bits then toward lower bits. Shifts by doubling
+// amounts carry the seeds along runs of any length in six steps.
+static uint64_t fillUp(uint64_t seeds, uint64_t run) {
+	for (int shift = 1; shift < 64; shift *= 2) {
+		seeds |= run & (seeds << shift);
+		run &= run << shift;
+	}
+	return seeds;
+}
+
+static uint64_t fillDown(uint64_t seeds, uint64_t run) {
+	for (int shift = 1; shift < 64; shift *= 2) {
+		seeds |= run & (seeds >> shift);
+		run &= run >> shift;
+	}
+	return seeds;
+}
+
+// Rows are swept down then up, each one growing from the row before it then along its runs of mask tiles, until a
+// pair of sweeps adds nothing. Open areas fill in one pair of sweeps, winding paths take one more per turn back.
+void BitBoard::floodFill(const BitBoard& mask) {
+	assert(isSameRect(mask));
+	scratch.resize(2 * (size_t)nbWords);
+	uint64_t* spread = scratch.data();
+	uint64_t* previous = scratch.data() + nbWords;
+	bool isChanged = true;
+	while (isChanged) {
+		isChanged = false;
+		for (int pass = 0; pass < 2; pass++)
+			for (int i = 0; i < height; i++) {
+				int row = pass == 0 ? i : height - 1 - i;
+				int from = pass == 0 ? row - 1 : row + 1;
+				uint64_t* tiles = rowWords(row);
+				const uint64_t* allowed = mask.rowWords(row);
+				std::copy(tiles, tiles + nbWords, previous);
+				if (from >= 0 && from < height) {
+					spreadRow(rowWords(from), spread);
+					for (int w = 0; w < nbWords; w++) tiles[w] |= spread[w] & allowed[w];
+				}
+				// Along the row, runs continue from one word into the next
+				uint64_t carry = 0;
+				for (int w = 0; w < nbWords; w++) {
+					tiles[w] = fillUp(tiles[w] | (carry & allowed[w]), allowed[w]);
+					carry = tiles[w] >> 63;
+				}
+				carry = 0;
+				for (int w = nbWords - 1; w >= 0; w--) {
+					tiles[w] = fillDown(tiles[w] | ((carry << 63) & allowed[w]), allowed[w]);
+					carry = tiles[w] & 1;
+				}
+				isChanged |= !std::equal(tiles, tiles + nbWords, previous);
+			}
+	}
+}
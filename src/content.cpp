@@ -0,0 +1,312 @@
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "main.hpp"
+
+static constexpr const char* FILE_NAMES[Content::NB_FILES] = {"enemies.txt", "items.txt", "floors.txt"};
+static constexpr char CACHE_MAGIC[8] = "UWDATA";
+// Enemy::AiType of each ai name of data/enemies.txt
+static constexpr const char* AI_NAMES[] = {"monster", "gremlin", "elf", "lich", "dragon"};
+
+static std::string_view trim(std::string_view text) {
+	while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+	while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+	return text;
+}
+
+static std::vector<std::string_view> split(std::string_view text, char separator) {
+	std::vector<std::string_view> fields;
+	while (true) {
+		size_t end = text.find(separator);
+		fields.push_back(trim(text.substr(0, end)));
+		if (end == std::string_view::npos) return fields;
+		text.remove_prefix(end + 1);
+	}
+}
+
+// Builds a Content from the text of the definition files, reporting errors with their file and line
+class ContentCompiler {
+   public:
+	ContentCompiler(Content& content) : content(content), fileName(NULL), lineNumber(0) {}
+
+	// Calls parseLine(fields) for every line that is not empty nor a comment
+	template <typename Function>
+	void parseFile(const char* name, std::string_view text, int nbFields, Function parseLine) {
+		fileName = name;
+		lineNumber = 0;
+		for (std::string_view line : split(text, '\n')) {
+			lineNumber++;
+			if (line.empty() || line.front() == '#') continue;
+			std::vector<std::string_view> fields = split(line, '|');
+			if ((int)fields.size() != nbFields) fail(tcod::stringf("expected %d fields separated by '|'", nbFields));
+			parseLine(fields);
+		}
+	}
+
+	[[noreturn]] void fail(const std::string& message) const {
+		throw std::runtime_error(tcod::stringf("data/%s:%d: %s", fileName, lineNumber, message.c_str()));
+	}
+
+	double toNumber(std::string_view field) const {
+		std::string text(field);
+		char* end = NULL;
+		double value = std::strtod(text.c_str(), &end);
+		if (text.empty() || *end != '\0') fail("invalid number '" + text + "'");
+		return value;
+	}
+
+	int toInt(std::string_view field) const {
+		double value = toNumber(field);
+		if (value != (int)value) fail("expected an integer, got '" + std::string(field) + "'");
+		return (int)value;
+	}
+
+	// Add text to the string pool, turning "\n" into new lines
+	uint32_t addString(std::string_view text) {
+		uint32_t offset = content.stringsSize;
+		for (size_t i = 0; i < text.size(); i++) {
+			char ch = text[i];
+			if (ch == '\\' && i + 1 < text.size() && text[i + 1] == 'n') {
+				ch = '\n';
+				i++;
+			}
+			push(ch);
+		}
+		push('\0');
+		return offset;
+	}
+
+	void parseEnemy(const std::vector<std::string_view>& fields) {
+		if (content.nbArchetypes == Content::MAX_ARCHETYPES)
+			fail(tcod::stringf("more than %d enemies", Content::MAX_ARCHETYPES));
+		if (fields[1].size() != 1) fail("the glyph must be one character");
+		Content::Archetype& archetype = content.archetypes[content.nbArchetypes++];
+		archetype.name = addString(fields[0]);
+		archetype.ch = fields[1][0];
+		archetype.maxHp = (float)toNumber(fields[2]);
+		archetype.defense = (float)toNumber(fields[3]);
+		archetype.power = (float)toNumber(fields[4]);
+		archetype.corpseName = addString(fields[5]);
+		auto ai = std::find(std::begin(AI_NAMES), std::end(AI_NAMES), fields[6]);
+		if (ai == std::end(AI_NAMES)) fail("unknown ai '" + std::string(fields[6]) + "'");
+		archetype.ai = (uint8_t)(ai - std::begin(AI_NAMES));
+	}
+
+	void parseItem(
+		const std::vector<std::string_view>& fields,
+		int (&weights)[Item::NB_KINDS],
+		bool (&isDefined)[Item::NB_KINDS]) {
+		Item::Kind kind = Item::getKindByName(fields[0]);
+		if (kind == Item::NO_KIND) fail("unknown item '" + std::string(fields[0]) + "'");
+		if (isDefined[kind]) fail("item '" + std::string(fields[0]) + "' is defined twice");
+		if (fields[1].size() != 1) fail("the glyph must be one character");
+		std::vector<std::string_view> color = split(fields[2], ' ');
+		if (color.size() != 3) fail("the color must be 3 numbers");
+		Content::ItemKind& item = content.items[kind];
+		item.name = addString(fields[0]);
+		item.ch = fields[1][0];
+		item.r = (uint8_t)toInt(color[0]);
+		item.g = (uint8_t)toInt(color[1]);
+		item.b = (uint8_t)toInt(color[2]);
+		weights[kind] = toInt(fields[3]);
+		item.defaultName = addString(fields[4]);
+		if (fields[4].size() > (size_t)NameTracker::MAX_CALL_STRING_LENGTH) fail("unidentified name is too long");
+		item.description = addString(fields[5]);
+		isDefined[kind] = true;
+	}
+
+	void parseFloor(const std::vector<std::string_view>& fields, int floor) {
+		if (floor >= Content::NB_FLOORS) fail(tcod::stringf("more than %d floors", Content::NB_FLOORS));
+		Content::Floor& table = content.floors[floor];
+		std::vector<std::string_view> items = split(fields[0], '-');
+		if (items.size() != 2) fail("items must be a range like 4-6");
+		table.minItems = toInt(items[0]);
+		table.maxItems = toInt(items[1]);
+		table.maxIdScrolls = toInt(fields[1]);
+		table.nbMonsters = toInt(fields[2]);
+		table.easyLayoutChance = (float)toNumber(fields[3]);
+		if (table.minItems < 0 || table.minItems > table.maxItems || table.maxIdScrolls < 0 || table.nbMonsters < 0)
+			fail("invalid item or monster counts");
+		if (table.easyLayoutChance < 0 || table.easyLayoutChance > 1) fail("easy layout chance must be in [0, 1]");
+		parseDistanceBand(fields[4], table.minStairsDistance, table.maxStairsDistance);
+		parseDistanceBand(fields[5], table.minEasyStairsDistance, table.maxEasyStairsDistance);
+
+		int generatorWeights[MapGenerator::NB_KINDS] = {};
+		for (std::string_view generator : split(fields[6], ',')) {
+			size_t space = generator.rfind(' ');
+			if (space == std::string_view::npos) fail("generators must be a list of 'name weight'");
+			std::string_view name = trim(generator.substr(0, space));
+			MapGenerator::Kind kind = MapGenerator::getKindByName(name);
+			if (kind == MapGenerator::NB_KINDS) fail("unknown generator '" + std::string(name) + "'");
+			generatorWeights[kind] = toInt(generator.substr(space + 1));
+		}
+		checkWeights(generatorWeights);
+		table.generators = AliasTable<MapGenerator::NB_KINDS>(generatorWeights);
+
+		int weights[Content::MAX_ARCHETYPES] = {};
+		for (std::string_view enemy : split(fields[7], ',')) {
+			size_t space = enemy.rfind(' ');
+			if (space == std::string_view::npos) fail("enemies must be a list of 'name weight'");
+			std::string_view name = trim(enemy.substr(0, space));
+			int archetype = 0;
+			while (archetype < content.nbArchetypes && name != content.getString(content.archetypes[archetype].name))
+				archetype++;
+			if (archetype == content.nbArchetypes) fail("unknown enemy '" + std::string(name) + "'");
+			weights[archetype] = toInt(enemy.substr(space + 1));
+		}
+		checkWeights(weights);
+		table.enemies = AliasTable<Content::MAX_ARCHETYPES>(weights);
+	}
+
+	// A range like 0.5-1 of fractions of the longest walk on a floor
+	void parseDistanceBand(std::string_view field, float& min, float& max) const {
+		std::vector<std::string_view> bounds = split(field, '-');
+		if (bounds.size() != 2) fail("stairs distance must be a range like 0.5-1");
+		min = (float)toNumber(bounds[0]);
+		max = (float)toNumber(bounds[1]);
+		if (min < 0 || min > max || max > 1) fail("stairs distance must be within [0, 1]");
+	}
+
+	// Weights of an AliasTable must be positive or zero, and not all zero
+	template <size_t N>
+	void checkWeights(const int (&weights)[N]) const {
+		int total = 0;
+		for (int weight : weights) {
+			if (weight < 0) fail("weights can not be negative");
+			total += weight;
+		}
+		if (total == 0) fail("weights add up to 0");
+	}
+
+   private:
+	Content& content;
+	const char* fileName;
+	int lineNumber;
+
+	void push(char ch) {
+		if (content.stringsSize == Content::STRINGS_SIZE) fail("too much text");
+		content.strings[content.stringsSize++] = ch;
+	}
+};
+
+static uint64_t hashFiles(const std::string (&texts)[Content::NB_FILES]) {
+	uint64_t hash = Assets::HASH_SEED;
+	for (const auto& text : texts) hash = Assets::hash("\xFF", Assets::hash(text, hash));
+	return hash;
+}
+
+// Ids in a cache are only meaningful with the names they were given for, so a build that adds, removes or reorders
+// items, ais or map generators must not use the caches of another one
+static uint64_t hashSchema() {
+	uint64_t hash = Assets::HASH_SEED;
+	auto addName = [&](const char* name) { hash = Assets::hash("\xFF", Assets::hash(name, hash)); };
+	for (int kind = 0; kind < Item::NB_KINDS; kind++) addName(Item::getName((Item::Kind)kind));
+	for (const char* name : AI_NAMES) addName(name);
+	for (int kind = 0; kind < MapGenerator::NB_KINDS; kind++) addName(MapGenerator::getName((MapGenerator::Kind)kind));
+	return hash;
+}
+
+Content* Content::compile(const std::string (&texts)[NB_FILES]) {
+	Content* content = new Content();
+	ContentCompiler compiler(*content);
+	try {
+		compiler.parseFile(FILE_NAMES[0], texts[0], 7, [&](const auto& fields) { compiler.parseEnemy(fields); });
+		if (content->nbArchetypes == 0) throw std::runtime_error("data/enemies.txt: no enemies");
+
+		int weights[Item::NB_KINDS] = {};
+		bool isDefined[Item::NB_KINDS] = {};
+		compiler.parseFile(FILE_NAMES[1], texts[1], 6, [&](const auto& fields) {
+			compiler.parseItem(fields, weights, isDefined);
+		});
+		for (int kind = 0; kind < Item::NB_KINDS; kind++)
+			if (!isDefined[kind])
+				throw std::runtime_error(
+					tcod::stringf("data/items.txt: '%s' is not defined", Item::getName((Item::Kind)kind)));
+		// Liquify draws among potions only, with the same relative weights
+		int potionWeights[NB_POTIONS] = {}, scrollWeights[NB_SCROLLS] = {};
+		std::copy(weights + Item::FIRST_POTION, weights + Item::FIRST_SCROLL, potionWeights);
+		std::copy(weights + Item::FIRST_SCROLL, weights + Item::NB_KINDS, scrollWeights);
+		compiler.checkWeights(potionWeights);
+		compiler.checkWeights(scrollWeights);
+		content->itemTable = AliasTable<Item::NB_KINDS>(weights);
+		content->potionTable = AliasTable<NB_POTIONS>(potionWeights);
+		content->scrollTable = AliasTable<NB_SCROLLS>(scrollWeights);
+
+		int nbFloors = 0;
+		compiler.parseFile(FILE_NAMES[2], texts[2], 8, [&](const auto& fields) {
+			compiler.parseFloor(fields, nbFloors++);
+		});
+		if (nbFloors != NB_FLOORS)
+			throw std::runtime_error(tcod::stringf("data/floors.txt: expected %d floors", NB_FLOORS));
+	} catch (...) {
+		delete content;
+		throw;
+	}
+	return content;
+}
+
+bool Content::isValid() const {
+	if (stringsSize == 0 || stringsSize > STRINGS_SIZE || strings[stringsSize - 1] != '\0') return false;
+	auto isString = [&](uint32_t offset) { return offset < stringsSize; };
+	if (nbArchetypes < 1 || nbArchetypes > MAX_ARCHETYPES) return false;
+	for (int i = 0; i < nbArchetypes; i++) {
+		const Archetype& archetype = archetypes[i];
+		if (!isString(archetype.name) || !isString(archetype.corpseName) || archetype.ai >= std::size(AI_NAMES))
+			return false;
+	}
+	for (const ItemKind& item : items)
+		if (!isString(item.name) || !isString(item.defaultName) || !isString(item.description)) return false;
+	if (!itemTable.isValid() || !potionTable.isValid() || !scrollTable.isValid()) return false;
+	for (const Floor& floor : floors)
+		if (!floor.generators.isValid() || !floor.enemies.isValid(nbArchetypes)) return false;
+	return true;
+}
+
+const Content* Content::load() {
+	std::string texts[NB_FILES];
+	for (int i = 0; i < NB_FILES; i++)
+		if (!Assets::readFile(FILE_NAMES[i], texts[i]))
+			throw std::runtime_error(tcod::stringf("Could not read data/%s.", FILE_NAMES[i]));
+	uint64_t hash = hashFiles(texts);
+	uint64_t schemaHash = hashSchema();
+
+	// Use the cache in place if it was built from the same files by the same build
+	std::filesystem::path cachePath = Engine::getPrefPath("content.cache");
+	if (!cachePath.empty()) {
+		MappedFile* cache = new MappedFile(cachePath);
+		if (cache->isOpen() && cache->size() == sizeof(CacheHeader) + sizeof(Content)) {
+			CacheHeader header;
+			std::memcpy(&header, cache->data(), sizeof(header));
+			if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header.version == CACHE_VERSION &&
+				header.contentSize == sizeof(Content) && header.hash == hash && header.schemaHash == schemaHash) {
+				// Mapped for the rest of the run, unless it is damaged and the files are parsed again
+				auto content = reinterpret_cast<const Content*>(cache->data() + sizeof(CacheHeader));
+				if (content->isValid()) return content;
+			}
+		}
+		delete cache;
+	}
+
+	Content* content = compile(texts);
+	if (!cachePath.empty()) {
+		CacheHeader header = {{}, CACHE_VERSION, (uint32_t)sizeof(Content), hash, schemaHash};
+		std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		std::vector<uint8_t> cache(sizeof(CacheHeader) + sizeof(Content));
+		std::memcpy(cache.data(), &header, sizeof(header));
+		std::memcpy(cache.data() + sizeof(header), content, sizeof(Content));
+		// A missing cache only costs parsing the files again next time
+		AtomicFile::write(cachePath, cache.data(), cache.size());
+	}
+	return content;
+}
+
+const Content& Content::get() {
+	// Thread safe, headless tools load it from several threads at once
+	static const Content* content = load();
+	return *content;
+}
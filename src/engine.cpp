@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <exception>
 #include <filesystem>
 #include <string>
 
@@ -8,31 +11,43 @@ static constexpr auto WHITE = tcod::ColorRGB{255, 255, 255};
 static constexpr auto RED = tcod::ColorRGB{255, 0, 0};
 static constexpr auto LIGHT_BLUE = tcod::ColorRGB{63, 63, 255};
 
-std::filesystem::path Engine::getDataDir() {
-	auto current = std::filesystem::current_path();
-	while (!std::filesystem::exists(current / "data")) {
-		auto parent = current.parent_path();
-		if (parent == current) {
-			throw std::runtime_error("Could not find the data directory.");
-		}
-		current = parent;
-	}
-	return current / "data";
+thread_local Engine engine;
+
+std::filesystem::path Engine::getPrefPath(const char* fileName) {
+	char* prefPath = SDL_GetPrefPath(NULL, "The Underworlder");
+	if (!prefPath) return {};
+	std::filesystem::path path = std::filesystem::path(prefPath) / fileName;
+	SDL_free(prefPath);
+	return path;
 }
 
 // Configure param settings and initialize members
 SDL_AppResult Engine::init(int argc, char** argv) {
+	startupTicks = phaseTicks = SDL_GetTicksNS();
+
 	auto params = TCOD_ContextParams{};
 	params.argc = argc;
 	params.argv = argv;
 	params.renderer_type = TCOD_RENDERER_SDL2;
-	params.vsync = 1;
+	auto pacing = FramePacer::parseArguments(argc, argv);
+	params.vsync = pacing.vsync;
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::strcmp(argv[i], "--map-size") == 0 && !Map::parseSize(argv[i + 1], mapWidth, mapHeight))
+			SDL_Log("Ignoring --map-size %s, expected WIDTHxHEIGHT up to %d", argv[i + 1], Map::MAX_SIZE);
+		if (std::strcmp(argv[i], "--map-generator") == 0) {
+			mapGenerator = MapGenerator::getKindByName(argv[i + 1]);
+			if (mapGenerator == MapGenerator::NB_KINDS)
+				SDL_Log("Ignoring --map-generator %s, expected bsp, caves, walk or maze", argv[i + 1]);
+		}
+	}
 	params.sdl_window_flags = SDL_WINDOW_RESIZABLE;
 	params.window_title = "The Underworlder";
 
 	// Load tileset
-	auto tileset = tcod::load_tilesheet(getDataDir() / "Zesty_curses_24x24.png", {16, 16}, tcod::CHARMAP_CP437);
+	bool isFromAtlas;
+	auto tileset = Assets::loadTilesheet("Zesty_curses_24x24.png", {16, 16}, tcod::CHARMAP_CP437, isFromAtlas);
 	params.tileset = tileset.get();
+	endStartupPhase(isFromAtlas ? "tileset (atlas)" : "tileset (decoded)");
 
 	// Load console
 	console = tcod::Console{CONSOLE_WIDTH, CONSOLE_HEIGHT};
@@ -40,14 +55,47 @@ SDL_AppResult Engine::init(int argc, char** argv) {
 
 	// Load context
 	context = tcod::Context(params);
+	endStartupPhase("window");
+
+	// Load it now rather than on first use, so it is counted, and so that invalid data files stop the game here
+	try {
+		Content::get();
+	} catch (const std::exception& error) {
+		SDL_Log("Could not load the game content: %s", error.what());
+		return SDL_APP_FAILURE;
+	}
+	endStartupPhase("content");
+
+	// Resume the last run if there is one
+	auto savePath = getSavePath();
+	if (SaveGame::load(savePath)) {
+		gui->message("Welcome back, stranger.\nPress '?' to view controls.", RED);
+	} else {
+		newGame();
+	}
+	if (!savePath.empty()) autoSaver = new AutoSaver(savePath);
+	framePacer = new FramePacer(pacing);
+	endStartupPhase("game");
+
+	return SDL_APP_CONTINUE;
+}
+
+void Engine::endStartupPhase(const char* phase) {
+	Uint64 ticks = SDL_GetTicksNS();
+	startupReport += tcod::stringf("%s %.1f ms, ", phase, (ticks - phaseTicks) / 1e6);
+	phaseTicks = ticks;
+}
 
+// Create the player, the first floor and the Gui
+void Engine::newGame() {
+	spatialIndex.reset(mapWidth, mapHeight);
 	// Create actors
-	player = new Actor(console.get_width() / 2, console.get_height() / 2, '@', "player", {200, 210, 220});
+	player = new Actor(CONSOLE_WIDTH / 2, CONSOLE_HEIGHT / 2, '@', "player", {200, 210, 220});
 	player->destructible = new PlayerDestructible(50, 2, "your cadaver");
 	player->attacker = new Attacker(35);
 	player->ai = new PlayerAi();
 	player->container = new Container(36);
-	actors.push_back(player);
+	addActor(player);
 
 	createNatureActor();
 
@@ -55,10 +103,10 @@ SDL_AppResult Engine::init(int argc, char** argv) {
 	stairs = new Actor(0, 0, '>', "stairs", WHITE);
 	stairs->blocks = false;
 	stairs->fovOnly = false;
-	actors.push_back(stairs);
+	addActor(stairs);
 
 	// Create map (after actors)
-	map = new Map(MAP_WIDTH, MAP_HEIGHT);
+	map = new Map(mapWidth, mapHeight);
 
 	// Make stairs the last actor
 	sendToBack(stairs);
@@ -73,20 +121,60 @@ SDL_AppResult Engine::init(int argc, char** argv) {
 	monsterSpawnRate = 50;
 	gameStatus = STARTUP;
 	lastMouseTileX = lastMouseTileY = 0;
+}
 
-	return SDL_APP_CONTINUE;
+// Free everything created by newGame(), safe to call more than once
+void Engine::endGame() {
+	// Free actor memories
+	spatialIndex.reset(mapWidth, mapHeight);
+	for (auto actor : actors) {
+		delete actor;
+	}
+	actors.clear();
+	player = stairs = nature = upStairs = NULL;
+	visitedFloors.clear();
+
+	// Free map memories
+	delete map;
+	map = NULL;
+
+	// Free Gui
+	delete gui;
+	gui = NULL;
+
+	delete nameTracker;
+	nameTracker = NULL;
+}
+
+void Engine::updateView() {
+	viewX = std::clamp(player->x - VIEW_WIDTH / 2, 0, std::max(0, map->width - VIEW_WIDTH));
+	viewY = std::clamp(player->y - VIEW_HEIGHT / 2, 0, std::max(0, map->height - VIEW_HEIGHT));
+}
+
+bool Engine::getMouseMapTile(int& x, int& y) const {
+	x = viewX + lastMouseTileX;
+	y = viewY + lastMouseTileY;
+	return lastMouseTileX >= 0 && lastMouseTileX < VIEW_WIDTH && lastMouseTileY >= 0 && lastMouseTileY < VIEW_HEIGHT;
 }
 
 // Render console graphics, including map, actors and gui
 void Engine::render(tcod::Console& console) {
 	// Render map tiles
-	map->render(console);
-
-	// Render actors if in FoV
-	for (auto actor : actors)
+	updateView();
+	map->render(console, viewX, viewY);
+
+	// Render actors in view if in FoV, in the order of the actor list
+	actorsInView.clear();
+	spatialIndex.forEachInRect(viewX, viewY, viewX + VIEW_WIDTH - 1, viewY + VIEW_HEIGHT - 1, [&](Actor* actor) {
+		actorsInView.push_back(actor);
+	});
+	std::sort(actorsInView.begin(), actorsInView.end(), [](const Actor* a, const Actor* b) {
+		return a->drawOrder < b->drawOrder;
+	});
+	for (auto actor : actorsInView)
 		if ((!actor->fovOnly && map->isExplored(actor->x, actor->y)) || map->isInFov(actor->x, actor->y) ||
 			map->isMapRevealed)
-			actor->render(console);
+			actor->render(console, viewX, viewY);
 
 	// Render Gui elements (on top, or modify the base console colors)
 	gui->render(console);
@@ -103,6 +191,17 @@ void Engine::render(tcod::Console& console) {
 
 // Called every frame, update actor turns if new turn, then render console graphics
 SDL_AppResult Engine::iterate() {
+	// Nothing on screen changes while waiting for input, so sleep until the next event rather than redraw the same frame
+	bool isWaiting = gameStatus == IDLE || gameStatus == MENU || gameStatus == DEFEAT ||
+					 (gameStatus == VICTORY && winEffect >= 255.0F);
+	if (framePacer->isReportDue()) SDL_Log("Frames: %s", framePacer->report().c_str());
+	if (isWaiting && !isFrameDirty) {
+		framePacer->waitForEvent();
+		return SDL_APP_CONTINUE;
+	}
+	isFrameDirty = false;
+	float frameSeconds = framePacer->beginFrame();
+
 	console.clear();
 
 	// Update FoV if needed, currently only on first frame and on player movement
@@ -113,16 +212,24 @@ SDL_AppResult Engine::iterate() {
 		gameStatus = MENU;
 	} else if (gameStatus == PLAYER_TURN) {
 		// If turn is spent go to OTHER_ACTORS_TURN, else return to idle
+		perfOverlay.beginTurnWork();
 		player->update();  // status updated inside playerAi
+		perfOverlay.endTurnWork();
 	} else if (gameStatus == OTHER_ACTORS_TURN) {
-		for (auto actor : actors)
-			if (actor != player) actor->update();
+		perfOverlay.beginTurnWork();
+		updateOtherActors();
+		perfOverlay.endTurnWork();
+		perfOverlay.endTurn();
 		gameStatus = IDLE;
+		if (autoSaver && !player->destructible->isDead() && ++turnsSinceAutoSave >= AUTOSAVE_INTERVAL) {
+			autoSaver->snapshot();
+			turnsSinceAutoSave = 0;
+		}
 	} else if (gameStatus == MENU_UPDATE) {
 		// Status updated inside
 		gui->update();
 	} else if (gameStatus == VICTORY) {
-		winEffect += 0.2F;
+		winEffect += WIN_EFFECT_SPEED * frameSeconds;
 	}
 
 	// Render graphics for this frame
@@ -131,6 +238,15 @@ SDL_AppResult Engine::iterate() {
 	// Update context with console
 	context.present(console);
 
+	if (startupTicks) {
+		endStartupPhase("first frame");
+		SDL_Log("Startup: %stotal %.1f ms", startupReport.c_str(), (phaseTicks - startupTicks) / 1e6);
+		startupTicks = 0;
+		startupReport.clear();
+	}
+	framePacer->endFrame();
+	perfOverlay.endFrame(framePacer->getStats().lastFrameNs);
+
 	return SDL_APP_CONTINUE;
 }
 
@@ -138,21 +254,31 @@ SDL_AppResult Engine::iterate() {
 SDL_AppResult Engine::handleEvent(const SDL_Event& event) {
 	lastEventType = event.type;
 
+	bool isInput = false;
 	if (event.type == SDL_EVENT_KEY_DOWN) {
 		lastKeyboardEvent = event.key;
+		isInput = true;
 	} else if (event.type == SDL_EVENT_MOUSE_MOTION) {
 		auto mouseEvent = event;
 		context.convert_event_coordinates(mouseEvent);
 		auto mouseTile = mouseEvent.motion;
+		// Moving within a tile changes nothing on screen
+		isInput = (int)mouseTile.x != lastMouseTileX || (int)mouseTile.y != lastMouseTileY;
 		lastMouseTileX = (int)mouseTile.x;
 		lastMouseTileY = (int)mouseTile.y;
 	} else if (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
 		lastMouseButton = event.button.button;
+		isInput = true;
+	} else if (event.type == SDL_EVENT_WINDOW_EXPOSED || event.type == SDL_EVENT_WINDOW_RESIZED ||
+			   event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED) {
+		markDirty();
 	} else if (event.type == SDL_EVENT_QUIT) {
 		return SDL_APP_SUCCESS;
 	}
 
-	if (event.type == SDL_EVENT_KEY_DOWN || SDL_EVENT_MOUSE_MOTION || SDL_EVENT_MOUSE_BUTTON_DOWN) {
+	if (isInput) {
+		// Mouse-look and menu highlights follow the mouse even when the input is otherwise ignored
+		markDirty();
 		// If game state is waiting for input, set state to wake them up to process the input
 		if (gameStatus == IDLE) {
 			gameStatus = PLAYER_TURN;
@@ -163,11 +289,32 @@ SDL_AppResult Engine::handleEvent(const SDL_Event& event) {
 	return SDL_APP_CONTINUE;
 }
 
+// Update every actor but the player. Actors may be added or reordered while updating (spawns, fires, corpses), so
+// the list is walked by index rather than by iterator. Actors out of ACTIVE_RANGE are skipped, but those with no
+// place on the map, nature and the fires burning other actors, always act.
+void Engine::updateOtherActors() {
+	for (size_t i = 0; i < actors.size(); i++) {
+		Actor* actor = actors[i];
+		bool isOffMap = actor->x < 0 || actor->y < 0;
+		bool isInRange = std::abs(actor->x - player->x) <= ACTIVE_RANGE && std::abs(actor->y - player->y) <= ACTIVE_RANGE;
+		if (actor != player && (isInRange || isOffMap)) actor->update();
+	}
+}
+
+void Engine::addActor(Actor* actor) {
+	actors.push_back(actor);
+	actor->drawOrder = nextDrawOrder++;
+	spatialIndex.insert(actor);
+	if (actor->blocks) freeTiles.addBlocker(actor->x, actor->y);
+}
+
 // Remove actor from the main actor list, note it's not deleted here
 void Engine::removeActor(Actor* actor) {
 	auto it = std::find(actors.begin(), actors.end(), actor);
 	assert(it != actors.end());
 	actors.erase(it);
+	spatialIndex.remove(actor);
+	if (actor->blocks) freeTiles.removeBlocker(actor->x, actor->y);
 }
 
 // Reorder actor to the beginning of the list, i.e. rendered at the back
@@ -176,92 +323,130 @@ void Engine::sendToBack(Actor* actor) {
 	assert(it != actors.end());
 	actors.erase(it);
 	actors.insert(actors.begin(), actor);
+	actor->drawOrder = nextBackDrawOrder--;
 }
 
 // Return an alive actor, including the player, at (x, y). Returns NULL if not found.
 Actor* Engine::getActor(int x, int y) const {
-	for (auto actor : actors) {
-		if (actor->x == x && actor->y == y && actor->destructible && !actor->destructible->isDead()) {
-			return actor;
-		}
-	}
-	return NULL;
+	Actor* found = NULL;
+	spatialIndex.forEachInRect(x, y, x, y, [&](Actor* actor) {
+		if (!found && actor->destructible && !actor->destructible->isDead()) found = actor;
+	});
+	return found;
 }
 
 // Returns the closest alive monster from position x,y within range. If range is 0, it's considered infinite. If
 // no monster is found within range, it returns NULL
 Actor* Engine::getClosestMonster(int x, int y, float range) const {
-	Actor* closest = NULL;
-	float bestDistance = 1E6f;
-	for (auto actor : actors) {
-		if (actor != player && actor->destructible && !actor->destructible->isDead()) {
-			float distance = actor->getDistance(x, y);
-			if (distance < bestDistance && (distance <= range || range == 0.0f)) {
-				bestDistance = distance;
-				closest = actor;
-			}
-		}
-	}
-	return closest;
+	return spatialIndex.findNearest(x, y, range, [&](Actor* actor) {
+		return actor != player && actor->destructible && !actor->destructible->isDead();
+	});
 }
 
 void Engine::createNatureActor() {
 	nature = new Actor(-1, -1, ' ', "Nature", RED);
 	nature->ai = new NatureAi(level);
-	actors.push_back(nature);
+	addActor(nature);
 }
 
 void Engine::nextLevel() {
-	if (level == 20) {
+	if (level == Content::NB_FLOORS) {
 		gui->message("Congratulations!\nYou found the exit and escaped!", LIGHT_BLUE);
 		gameStatus = VICTORY;
 		winEffect = 0.0;
 		return;
 	}
-	level++;
-	if (level == 11)
-		monsterSpawnRate = 40;
-	else if (level >= 19)
-		monsterSpawnRate = 30;
-	if (level == 11)
-		fovRadius = 9;
-	else if (level == 12)
-		fovRadius = 8;
-	else if (level == 14)
-		fovRadius = 7;
-	else if (level == 17)
-		fovRadius = 6;
-	else if (level == 19)
-		fovRadius = 5;
+	int newLevel = level + 1;
+	// Difficulty only rises the first time a floor is reached
+	bool isNewFloor = (size_t)newLevel >= visitedFloors.size() || visitedFloors[newLevel].empty();
+	if (isNewFloor) {
+		if (newLevel == 11)
+			monsterSpawnRate = 40;
+		else if (newLevel >= 19)
+			monsterSpawnRate = 30;
+		if (newLevel == 11)
+			fovRadius = 9;
+		else if (newLevel == 12)
+			fovRadius = 8;
+		else if (newLevel == 14)
+			fovRadius = 7;
+		else if (newLevel == 17)
+			fovRadius = 6;
+		else if (newLevel == 19)
+			fovRadius = 5;
+	}
 	gui->message("You descended deeper...", LIGHT_BLUE);
-	// Regenerate map
+	changeLevel(newLevel);
+}
+
+void Engine::previousLevel() {
+	gui->message("You climbed up...", LIGHT_BLUE);
+	changeLevel(level - 1);
+}
+
+void Engine::changeLevel(int newLevel) {
+	bool isGoingDown = newLevel > level;
+	if (visitedFloors.size() <= (size_t)std::max(level, newLevel)) visitedFloors.resize(std::max(level, newLevel) + 1);
+	// A floor that can not be kept is generated again when entered
+	if (!SaveGame::writeFloor(visitedFloors[level])) visitedFloors[level].clear();
+	level = newLevel;
+	std::vector<uint8_t>& snapshot = visitedFloors[level];
+	if (!snapshot.empty() && SaveGame::readFloor(snapshot.data(), snapshot.size())) {
+		// Arrive on the stairs leading back to the floor just left
+		Actor* arrival = isGoingDown ? upStairs : stairs;
+		if (arrival) player->moveTo(arrival->x, arrival->y);
+	} else {
+		clearFloor();
+		map = new Map(mapWidth, mapHeight);
+		sendToBack(stairs);
+		createNatureActor();
+		// Generated floors start on their up stairs
+		if (level > 1) {
+			upStairs = new Actor(player->x, player->y, '<', "up stairs", WHITE);
+			upStairs->blocks = false;
+			upStairs->fovOnly = false;
+			addActor(upStairs);
+			sendToBack(upStairs);
+		}
+	}
+	// The current floor is only kept decompressed, its snapshot is outdated from here on
+	std::vector<uint8_t>().swap(snapshot);
+	map->computeFov();
+	gameStatus = IDLE;
+}
+
+void Engine::clearFloor() {
 	delete map;
+	map = NULL;
+	nature = upStairs = NULL;
 	// Delete all actors but player and stairs
 	std::vector<Actor*> actorsToBeDeleted = {};
 	for (auto actor : actors)
 		if (actor != player && actor != stairs) actorsToBeDeleted.push_back(actor);
-	for (auto actor : actorsToBeDeleted) removeActor(actor);
-	// Create a new map
-	map = new Map(MAP_WIDTH, MAP_HEIGHT);
-	sendToBack(stairs);
-	createNatureActor();
-	map->computeFov();
-	gameStatus = IDLE;
-}
-
-// Called on windows exit
-void Engine::shutdown() {}
-
-// Destructor
-Engine::~Engine() {
-	// Free actor memories
-	for (auto actor : actors) {
+	for (auto actor : actorsToBeDeleted) {
+		removeActor(actor);
 		delete actor;
 	}
+}
 
-	// Free map memories
-	delete map;
-
-	// Free Gui
-	delete gui;
+// Called on windows exit, keep the run unless it is over
+void Engine::shutdown() {
+	if (framePacer) SDL_Log("Frames: %s", framePacer->report().c_str());
+	delete framePacer;
+	framePacer = NULL;
+
+	// Let the last autosave finish so it can not overwrite what is done below
+	delete autoSaver;
+	autoSaver = NULL;
+	auto savePath = getSavePath();
+	if (savePath.empty() || !player) return;
+	if (!player->destructible->isDead() && gameStatus != VICTORY) {
+		if (!SaveGame::save(savePath)) SDL_Log("Could not save the game to %s", savePath.string().c_str());
+	} else {
+		std::error_code error;
+		std::filesystem::remove(savePath, error);
+	}
 }
+
+// Destructor
+Engine::~Engine() { endGame(); }
@@ -0,0 +1,102 @@
+#include "framepacer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "main.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+FramePacer::Settings FramePacer::parseArguments(int argc, char** argv) {
+	Settings settings;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--no-vsync") == 0) {
+			settings.vsync = false;
+		} else if (std::strcmp(argv[i], "--max-fps") == 0 && hasValue) {
+			settings.maxFps = std::max(0, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--idle-fps") == 0 && hasValue) {
+			settings.idleFps = std::max(0, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--frame-report") == 0 && hasValue) {
+			settings.reportInterval = std::max(0, std::atoi(argv[++i]));
+		}
+	}
+	return settings;
+}
+
+FramePacer::FramePacer(const Settings& settings) : settings(settings) {
+	stats.startTicks = SDL_GetTicksNS();
+	stats.startCpu = getCpuSeconds();
+}
+
+// std::clock() is the process time everywhere but on Windows, where it counts wall clock time
+double FramePacer::getCpuSeconds() {
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+	auto toTicks = [](const FILETIME& time) { return ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime; };
+	return (toTicks(kernel) + toTicks(user)) / 1e7;	 // 100 ns ticks
+#else
+	return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+void FramePacer::waitForEvent() {
+	stats.idleWakeUps++;
+#ifndef __EMSCRIPTEN__	// The browser paces iterations itself and can not block
+	SDL_WaitEventTimeout(NULL, settings.idleFps > 0 ? 1000 / settings.idleFps : -1);
+#endif
+}
+
+float FramePacer::beginFrame() {
+	frameStart = SDL_GetTicksNS();
+	// Long waits for input would otherwise make animations jump
+	float seconds = lastFrameStart ? std::min((frameStart - lastFrameStart) / 1e9F, 0.1F) : 0.0F;
+	lastFrameStart = frameStart;
+	return seconds;
+}
+
+void FramePacer::endFrame() {
+	int fps = settings.maxFps > 0 ? settings.maxFps : settings.vsync ? 0 : FALLBACK_FPS;
+#ifndef __EMSCRIPTEN__
+	if (fps > 0) {
+		Uint64 frameNs = 1000000000 / fps;
+		Uint64 elapsed = SDL_GetTicksNS() - frameStart;
+		if (elapsed < frameNs) SDL_DelayNS(frameNs - elapsed);
+	}
+#endif
+	Uint64 frameTime = SDL_GetTicksNS() - frameStart;
+	stats.frames++;
+	stats.frameNsTotal += frameTime;
+	stats.frameNsMax = std::max(stats.frameNsMax, frameTime);
+	stats.lastFrameNs = frameTime;
+}
+
+bool FramePacer::isReportDue() const {
+	return settings.reportInterval > 0 && SDL_GetTicksNS() - stats.startTicks >= settings.reportInterval * 1000000000ULL;
+}
+
+std::string FramePacer::report() {
+	double seconds = (SDL_GetTicksNS() - stats.startTicks) / 1e9;
+	double cpuSeconds = getCpuSeconds() - stats.startCpu;
+	std::string report = tcod::stringf(
+		"%d frames in %.1f s (%.1f per second), frame time %.2f ms average %.2f ms max, %d idle wake-ups, "
+		"CPU %.1f%%",
+		stats.frames,
+		seconds,
+		seconds > 0 ? stats.frames / seconds : 0.0,
+		stats.frames ? stats.frameNsTotal / 1e6 / stats.frames : 0.0,
+		stats.frameNsMax / 1e6,
+		stats.idleWakeUps,
+		seconds > 0 ? 100.0 * cpuSeconds / seconds : 0.0);
+	stats = Stats();
+	stats.startTicks = SDL_GetTicksNS();
+	stats.startCpu = getCpuSeconds();
+	return report;
+}
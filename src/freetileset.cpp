@@ -0,0 +1,58 @@
+#include "freetileset.hpp"
+
+#include "main.hpp"
+
+void FreeTileSet::build(const Map& map, const std::vector<Actor*>& actors) {
+	width = map.width;
+	height = map.height;
+	walkable.assign(width * height, 0);
+	blockers.assign(width * height, 0);
+	positions.assign(width * height, -1);
+	tiles.clear();
+	for (auto actor : actors)
+		if (actor->blocks && isInside(actor->x, actor->y)) blockers[actor->x + actor->y * width]++;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) {
+			walkable[x + y * width] = map.isWalkable(x, y);
+			update(x + y * width);
+		}
+}
+
+void FreeTileSet::setWalkable(int x, int y, bool isWalkable) {
+	if (!isInside(x, y)) return;
+	walkable[x + y * width] = isWalkable;
+	update(x + y * width);
+}
+
+void FreeTileSet::addBlocker(int x, int y) {
+	if (!isInside(x, y)) return;
+	blockers[x + y * width]++;
+	update(x + y * width);
+}
+
+void FreeTileSet::removeBlocker(int x, int y) {
+	if (!isInside(x, y) || blockers[x + y * width] == 0) return;
+	blockers[x + y * width]--;
+	update(x + y * width);
+}
+
+void FreeTileSet::moveBlocker(int oldX, int oldY, int newX, int newY) {
+	removeBlocker(oldX, oldY);
+	addBlocker(newX, newY);
+}
+
+void FreeTileSet::update(int tile) {
+	bool isFree = walkable[tile] && blockers[tile] == 0;
+	int& position = positions[tile];
+	if (isFree && position < 0) {
+		position = (int)tiles.size();
+		tiles.push_back(tile);
+	} else if (!isFree && position >= 0) {
+		// Move the last tile into the hole
+		int last = tiles.back();
+		tiles[position] = last;
+		positions[last] = position;
+		tiles.pop_back();
+		position = -1;
+	}
+}
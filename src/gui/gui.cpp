@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <string>
 
 #include "main.hpp"
@@ -16,40 +19,221 @@ static constexpr auto DARKER_RED = tcod::ColorRGB{127, 0, 0};
 static constexpr auto LIGHT_GREY = tcod::ColorRGB{159, 159, 159};
 static constexpr auto LIGHT_GREEN = tcod::ColorRGB{63, 255, 63};
 
-Gui::Gui() : guiConsole(tcod::Console{engine.MAP_WIDTH, PANEL_HEIGHT}), isMenuOpen(false), menu(NULL) { log.clear(); }
+Gui::Gui()
+	: guiConsole(tcod::Console{engine.CONSOLE_WIDTH, PANEL_HEIGHT}),
+	  isMenuOpen(false),
+	  menu(NULL),
+	  logStart(0),
+	  logSize(0),
+	  lastMessageLines(0),
+	  history(new MessageHistory()) {}
 
-Gui::~Gui() {
-	for (auto message : log) delete message;
+Gui::~Gui() { delete history; }
+
+// Calls function(line) for every line of text, a trailing newline does not add an empty line
+template <typename Function>
+static void forEachLine(std::string_view text, Function function) {
+	while (!text.empty()) {
+		size_t end = text.find('\n');
+		function(text.substr(0, end));
+		if (end == std::string_view::npos) break;
+		text.remove_prefix(end + 1);
+	}
+}
+
+void Gui::message(std::string_view text, const tcod::ColorRGB& color) {
+	int nbLines = 0;
+	forEachLine(text, [&nbLines](std::string_view) { nbLines++; });
+	if (nbLines == 0) return;
+
+	// Same message as the last one: count it instead of adding its lines again
+	if (nbLines == lastMessageLines) {
+		bool isRepeated = true;
+		int i = logSize - nbLines;
+		forEachLine(text, [&](std::string_view line) {
+			const Message& previous = logLine(i++);
+			isRepeated = isRepeated && previous.event == TEXT && previous.getText(NULL, 0) == Message::truncate(line) &&
+						 previous.color == color;
+		});
+		if (isRepeated) {
+			logLine(logSize - 1).count++;
+			return;
+		}
+	}
+
+	forEachLine(text, [&](std::string_view line) { addLine(line, color); });
+	lastMessageLines = std::min(nbLines, LOG_CAPACITY);
+}
+
+void Gui::event(Event event, const Actor* subject, const Actor* object, float value, const tcod::ColorRGB& color) {
+	Message message = {};
+	message.event = event;
+	message.flags = (subject && subject == engine.player ? Message::SUBJECT_IS_PLAYER : 0) |
+					(object && object == engine.player ? Message::OBJECT_IS_PLAYER : 0);
+	message.color = color;
+	message.value = value;
+	message.subject = subject ? subject->name : NULL;
+	message.object = object ? object->name : NULL;
+	addEvent(message);
 }
 
-Gui::Message::Message(std::string text, const tcod::ColorRGB& color) : text(text), color(color) {}
+void Gui::event(const char* format, const char* name, float value, const tcod::ColorRGB& color) {
+	assert(!std::strchr(format, '\n'));
+	Message message = {};
+	message.event = CUSTOM;
+	message.color = color;
+	message.value = value;
+	message.format = format;
+	message.subject = name;
+	addEvent(message);
+}
 
-Gui::Message::~Message() {}
+// Append an event line, or count it if it repeats the last message
+void Gui::addEvent(const Message& message) {
+	if (lastMessageLines == 1 && logLine(logSize - 1).isSameAs(message)) {
+		logLine(logSize - 1).count++;
+		return;
+	}
+	Message& line = pushLine();
+	line = message;
+	line.count = 1;
+	lastMessageLines = 1;
+}
 
-void Gui::message(std::string text, const tcod::ColorRGB& color) {
-	// Split text by newlines
-	std::vector<std::string> lines;
-	size_t start = 0;
-	size_t len = text.length();
-	for (size_t i = 0; i < len; ++i) {
-		if (text[i] == '\n') {
-			lines.emplace_back(text.substr(start, i - start));
-			start = i + 1;
+// Append a line of text, overwriting the oldest line if the log is full
+void Gui::addLine(std::string_view text, const tcod::ColorRGB& color, int count) {
+	Message& line = pushLine();
+	text = Message::truncate(text);
+	line = {};
+	line.event = TEXT;
+	std::memcpy(line.text, text.data(), text.size());
+	line.text[text.size()] = '\0';
+	line.length = (uint8_t)text.size();
+	line.color = color;
+	line.count = count;
+	lastMessageLines = 0;
+}
+
+Gui::Message& Gui::pushLine() {
+	if (logSize == LOG_CAPACITY) {
+		// Unless history is disabled, keep the oldest line in it as text, the actors its event refers to may not
+		// outlive the log
+		if (history) {
+			const Message& oldest = logLine(0);
+			char buffer[Message::MAX_LENGTH + 1];
+			history->add(oldest.getText(buffer, sizeof(buffer)), oldest.color, oldest.count);
 		}
+		logStart = (logStart + 1) % LOG_CAPACITY;
+		logSize--;
 	}
-	if (start < len) {
-		lines.emplace_back(text.substr(start));
+	return logLine(logSize++);
+}
+
+int Gui::getHistorySize() const { return (history ? history->size() : 0) + logSize; }
+
+std::string_view Gui::getHistoryLine(int i, char* buffer, size_t size, tcod::ColorRGB& color, int& count) {
+	int historySize = history ? history->size() : 0;
+	if (i < historySize) {
+		MessageHistory::Line line = history->get(i);
+		color = line.color;
+		count = line.count;
+		return line.text;
 	}
+	const Message& message = logLine(i - historySize);
+	color = message.color;
+	count = message.count;
+	return message.getText(buffer, size);
+}
 
-	for (auto line : lines) {
-		// Make room for the new message
-		if (log.size() == MSG_HEIGHT) {
-			Message* toRemove = log[0];
-			log.erase(log.begin());
-			delete toRemove;
+size_t Gui::getHistoryMemoryUsage() const {
+	return (history ? history->getMemoryUsage() : 0) + sizeof(log);
+}
+
+void Gui::disableHistory() {
+	delete history;
+	history = NULL;
+}
+
+bool Gui::Message::isSameAs(const Message& other) const {
+	if (event != other.event || flags != other.flags || !(color == other.color)) return false;
+	if (event == TEXT) return std::string_view(text, length) == std::string_view(other.text, other.length);
+	return value == other.value && format == other.format && subject == other.subject && object == other.object;
+}
+
+std::string_view Gui::Message::getText(char* buffer, size_t size) const {
+	if (event == TEXT) return {text, length};
+	bool isSubjectPlayer = flags & SUBJECT_IS_PLAYER;
+	const char* subjectName = isSubjectPlayer ? "You" : subject;
+	const char* verbEnding = isSubjectPlayer ? "" : "s";
+	const char* objectName = flags & OBJECT_IS_PLAYER ? "you" : object;
+	int length = 0;
+	switch (event) {
+		case ATTACK:
+			length =
+				std::snprintf(buffer, size, "%s attack%s %s for %g HP.", subjectName, verbEnding, objectName, value);
+			break;
+		case ATTACK_NO_EFFECT:
+			length = std::snprintf(
+				buffer, size, "%s attack%s %s but it has no effect!", subjectName, verbEnding, objectName);
+			break;
+		case ATTACK_IN_VAIN:
+			length = std::snprintf(buffer, size, "%s attacks %s in vain.", subject, object);
+			break;
+		case BURN:
+			length = std::snprintf(buffer, size, "%s get%s burned for %g HP.", subjectName, verbEnding, value);
+			break;
+		case POWER_UP:
+			length = std::snprintf(buffer, size, "%s become%s more powerful!", subjectName, verbEnding);
+			break;
+		case POWER_DOWN:
+			length = std::snprintf(buffer, size, "%s become%s weaker!", subjectName, verbEnding);
+			break;
+		case DEATH:
+			length = std::snprintf(buffer, size, "%s is dead.", subject);
+			break;
+		case CUSTOM:
+			length = std::snprintf(buffer, size, format, subject, value);
+			break;
+		default:
+			break;
+	}
+	return {buffer, (size_t)std::clamp(length, 0, (int)size - 1)};
+}
+
+// Escape text for a JSON string
+static void writeJsonString(FILE* file, std::string_view text) {
+	std::fputc('"', file);
+	for (char ch : text) {
+		if (ch == '"' || ch == '\\')
+			std::fprintf(file, "\\%c", ch);
+		else if ((unsigned char)ch < 0x20)
+			std::fprintf(file, "\\u%04x", ch);
+		else
+			std::fputc(ch, file);
+	}
+	std::fputc('"', file);
+}
+
+void Gui::exportLog(FILE* file) const {
+	static constexpr const char* EVENT_NAMES[NB_EVENTS] = {
+		"text", "attack", "attack_no_effect", "attack_in_vain", "burn", "power_up", "power_down", "death", "custom"};
+	for (int i = 0; i < logSize; i++) {
+		const Message& message = logLine(i);
+		char buffer[Message::MAX_LENGTH + 1];
+		std::fprintf(file, "{\"event\":\"%s\",\"count\":%d", EVENT_NAMES[message.event], message.count);
+		if (message.event != TEXT) {
+			auto actorName = [&message](uint8_t playerFlag, const char* name) {
+				return message.flags & playerFlag ? "player" : name ? name : "";
+			};
+			std::fprintf(file, ",\"subject\":");
+			writeJsonString(file, actorName(Message::SUBJECT_IS_PLAYER, message.subject));
+			std::fprintf(file, ",\"object\":");
+			writeJsonString(file, actorName(Message::OBJECT_IS_PLAYER, message.object));
+			std::fprintf(file, ",\"value\":%g", message.value);
 		}
-		Message* msg = new Message(line, color);
-		log.push_back(msg);
+		std::fprintf(file, ",\"text\":");
+		writeJsonString(file, message.getText(buffer, sizeof(buffer)));
+		std::fprintf(file, "}\n");
 	}
 }
 
@@ -67,15 +251,28 @@ void Gui::render(tcod::Console& mainConsole) {
 		LIGHT_GREEN,
 		LIGHT_RED,
 		DARKER_RED);
-	// Draw the message log
-	int y = 1;
-	float colorCoef = 0.4f;
-	for (auto message : log) {
-		auto currentColor = tcod::ColorRGB{TCODColor::lerp(message->color, BLACK, 1.0F - colorCoef)};
-		tcod::print(guiConsole, {MSG_X, y}, message->text, currentColor, std::nullopt);
-		y++;
-		if (colorCoef < 1.0f) {
-			colorCoef += 0.3f;
+	// Draw the last lines of the message log, or the performance overlay in their place
+	if (engine.perfOverlay.isVisible) {
+		engine.perfOverlay.render(guiConsole, MSG_X, 1);
+	} else {
+		int y = 1;
+		float colorCoef = 0.4f;
+		for (int i = std::max(0, logSize - MSG_HEIGHT); i < logSize; i++) {
+			const Message& message = logLine(i);
+			auto currentColor = tcod::ColorRGB{TCODColor::lerp(message.color, BLACK, 1.0F - colorCoef)};
+			char buffer[Message::MAX_LENGTH + 1];
+			std::string_view text = message.getText(buffer, sizeof(buffer));
+			char countedText[Message::MAX_LENGTH + 16];
+			if (message.count > 1) {
+				int length = std::snprintf(
+					countedText, sizeof(countedText), "%.*s (x%d)", (int)text.size(), text.data(), message.count);
+				text = std::string_view(countedText, std::min<size_t>(length, sizeof(countedText) - 1));
+			}
+			tcod::print(guiConsole, {MSG_X, y}, text, currentColor, std::nullopt);
+			y++;
+			if (colorCoef < 1.0f) {
+				colorCoef += 0.3f;
+			}
 		}
 	}
 	// Draw actor names selected by mouse, if in FoV
@@ -85,7 +282,7 @@ void Gui::render(tcod::Console& mainConsole) {
 	tcod::print(guiConsole, {2, 3}, tcod::stringf("Floor %d", engine.level), WHITE, std::nullopt);
 
 	// Blit GUI console to the main console
-	tcod::blit(mainConsole, guiConsole, {0, engine.MAP_HEIGHT}, {0, 0, engine.MAP_WIDTH, PANEL_HEIGHT}, 0.7f, 0.7f);
+	tcod::blit(mainConsole, guiConsole, {0, engine.VIEW_HEIGHT}, {0, 0, engine.CONSOLE_WIDTH, PANEL_HEIGHT}, 0.7f, 0.7f);
 
 	// Blit menu console if it is ready
 	if (isMenuOpen) {
@@ -125,18 +322,18 @@ void Gui::renderBar(
 }
 
 void Gui::renderMouseLook() {
-	int cx = engine.lastMouseTileX, cy = engine.lastMouseTileY;
-	if (!engine.map->isInFov(cx, cy)) {
+	int cx, cy;
+	if (!engine.getMouseMapTile(cx, cy) || !engine.map->isInFov(cx, cy)) {
 		// If mouse is out of fov, nothing to render
 		return;
 	}
 	std::string allNames = "";
 	bool first = true;
-	for (auto actor : engine.actors) {
-		// Find actors under the mouse cursor
+	// Find actors under the mouse cursor
+	engine.spatialIndex.forEachInRect(cx, cy, cx, cy, [&](Actor* actor) {
 		bool corpseOrEnemyOrItem = (actor->destructible && actor->destructible->isDead()) || actor->pickable ||
 								   (actor->destructible && !actor->destructible->isDead() && actor != engine.player);
-		if (corpseOrEnemyOrItem && actor->x == cx && actor->y == cy &&
+		if (corpseOrEnemyOrItem &&
 			((!actor->fovOnly && engine.map->isExplored(actor->x, actor->y)) ||
 			 engine.map->isInFov(actor->x, actor->y) || engine.map->isMapRevealed)) {
 			if (!first) {
@@ -149,7 +346,7 @@ void Gui::renderMouseLook() {
 			else
 				allNames += actor->name;
 		}
-	}
+	});
 	// Display the list of actors under the mouse cursor
 	tcod::print(guiConsole, {1, 0}, allNames, LIGHT_GREY, std::nullopt);
 }
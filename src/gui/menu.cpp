@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 
 #include "main.hpp"
 
@@ -361,7 +363,18 @@ void InventoryMenu::render(tcod::Console& mainConsole) {
 
 TilePickMenu::TilePickMenu(
 	TargetSelector* invoker, Actor* owner, Actor* wearer, bool allowCancel, TilePickRange pickRange)
-	: invoker(invoker), owner(owner), wearer(wearer), allowCancel(allowCancel), pickRange(pickRange) {}
+	: invoker(invoker), owner(owner), wearer(wearer), allowCancel(allowCancel), pickRange(pickRange) {
+	const BitBoard& fov = engine.map->getFov();
+	pickableTiles = fov;
+	BitBoard tiles(fov.getX(), fov.getY(), fov.getWidth(), fov.getHeight());
+	engine.map->getTiles(Map::TILE_WALKABLE, tiles);
+	pickableTiles &= tiles;
+	if (maxRange != 0) {
+		tiles.clear();
+		tiles.setDisc(wearer->x, wearer->y, maxRange);
+		pickableTiles &= tiles;
+	}
+}
 
 void TilePickMenu::handleCancel() {
 	if (allowCancel) {
@@ -393,9 +406,8 @@ void TilePickMenu::update() {
 	}
 	if (engine.lastEventType == SDL_EVENT_MOUSE_BUTTON_DOWN) {
 		if (engine.lastMouseButton == SDL_BUTTON_LEFT) {
-			int x = engine.lastMouseTileX, y = engine.lastMouseTileY;
-			if (engine.map->isInFov(x, y) && (maxRange == 0 || wearer->getDistance(x, y) <= maxRange) &&
-				engine.map->isWalkable(x, y)) {
+			int x, y;
+			if (engine.getMouseMapTile(x, y) && pickableTiles.get(x, y)) {
 				Menu* nextMenu = invoker->tilePickCallback(owner, wearer, false, x, y, this);
 				if (nextMenu == NULL) {
 					// Turn spent successfully
@@ -421,35 +433,33 @@ void TilePickMenu::update() {
 }
 
 void TilePickMenu::render(tcod::Console& mainConsole) {
-	Map* map = engine.map;
-	for (int cx = 0; cx < map->width; cx++) {
-		for (int cy = 0; cy < map->height; cy++) {
-			if (engine.map->isInFov(cx, cy) && (maxRange == 0 || wearer->getDistance(cx, cy) <= maxRange) &&
-				engine.map->isWalkable(cx, cy)) {
-				TCOD_ColorRGBA col = mainConsole.at({cx, cy}).bg;
-
-				// Highlight selectable tiles by greenifying
-				float p = 0.5f;
-				TCOD_ColorRGBA hiCol;
+	pickableTiles.forEach([&](int x, int y) {
+		// (cx, cy) on the console
+		int cx = x - engine.viewX, cy = y - engine.viewY;
+		if (cx >= 0 && cx < Engine::VIEW_WIDTH && cy >= 0 && cy < Engine::VIEW_HEIGHT) {
+			TCOD_ColorRGBA col = mainConsole.at({cx, cy}).bg;
+
+			// Highlight selectable tiles by greenifying
+			float p = 0.5f;
+			TCOD_ColorRGBA hiCol;
+			hiCol.r = 120;
+			hiCol.g = 255;
+			hiCol.b = 120;
+			hiCol.a = 255;
+			if (engine.lastMouseTileX == cx && engine.lastMouseTileY == cy) {
 				hiCol.r = 120;
-				hiCol.g = 255;
-				hiCol.b = 120;
+				hiCol.g = 120;
+				hiCol.b = 255;
 				hiCol.a = 255;
-				if (engine.lastMouseTileX == cx && engine.lastMouseTileY == cy) {
-					hiCol.r = 120;
-					hiCol.g = 120;
-					hiCol.b = 255;
-					hiCol.a = 255;
-				}
-				col = {
-					static_cast<uint8_t>(col.r * p + hiCol.r * (1 - p)),
-					static_cast<uint8_t>(col.g * p + hiCol.g * (1 - p)),
-					static_cast<uint8_t>(col.b * p + hiCol.b * (1 - p)),
-					col.a};
-				mainConsole.at({cx, cy}).bg = col;
 			}
+			col = {
+				static_cast<uint8_t>(col.r * p + hiCol.r * (1 - p)),
+				static_cast<uint8_t>(col.g * p + hiCol.g * (1 - p)),
+				static_cast<uint8_t>(col.b * p + hiCol.b * (1 - p)),
+				col.a};
+			mainConsole.at({cx, cy}).bg = col;
 		}
-	}
+	});
 }
 
 ItemPickMenu::ItemPickMenu(TargetSelector* invoker, Actor* owner, Actor* wearer, bool allowCancel)
@@ -654,8 +664,14 @@ Rest for a turn - s
 
 Descend the stairs - >
 
+Climb the up stairs - <
+
 Pick up item at foot - g
 
+Message history - m
+
+Performance overlay - F3
+
 Cancel - Esc
 		)");
 	tcod::print_rect(controlsConsole, {0, 0, CONTROL_WIDTH, CONTROL_HEIGHT}, controlsText, WHITE, BLACK);
@@ -678,3 +694,144 @@ void ControlsMenu::render(tcod::Console& mainConsole) {
 		0.95F,
 		0.8F);
 }
+
+HistoryMenu::HistoryMenu()
+	: historyConsole(tcod::Console{HISTORY_WIDTH, HISTORY_HEIGHT}),
+	  bottomLine(engine.gui->getHistorySize()),
+	  matchLine(-1),
+	  onSearch(false) {}
+
+void HistoryMenu::scrollTo(int newBottomLine) {
+	int size = engine.gui->getHistorySize();
+	bottomLine = std::clamp(newBottomLine, std::min(size, PAGE_LINES), size);
+}
+
+// Case insensitive
+static bool containsText(std::string_view text, std::string_view searched) {
+	auto it = std::search(text.begin(), text.end(), searched.begin(), searched.end(), [](char a, char b) {
+		return std::tolower((unsigned char)a) == std::tolower((unsigned char)b);
+	});
+	return it != text.end();
+}
+
+bool HistoryMenu::search(bool isBackward) {
+	if (searchString.empty()) return false;
+	int size = engine.gui->getHistorySize();
+	int step = isBackward ? -1 : 1;
+	int start = matchLine != -1 ? matchLine + step : isBackward ? bottomLine - 1 : std::max(0, bottomLine - PAGE_LINES);
+	for (int i = start; i >= 0 && i < size; i += step) {
+		char buffer[Gui::LINE_BUFFER_SIZE];
+		tcod::ColorRGB color;
+		int count;
+		if (containsText(engine.gui->getHistoryLine(i, buffer, sizeof(buffer), color, count), searchString)) {
+			matchLine = i;
+			// Scroll only if the line is not visible
+			if (i >= bottomLine || i < bottomLine - PAGE_LINES) scrollTo(i + PAGE_LINES / 2);
+			return true;
+		}
+	}
+	return false;
+}
+
+void HistoryMenu::update() {
+	engine.gameStatus = Engine::MENU;
+	if (engine.lastEventType == SDL_EVENT_MOUSE_BUTTON_DOWN && engine.lastMouseButton == SDL_BUTTON_RIGHT) {
+		closeWithState(Engine::IDLE);
+		return;
+	}
+	if (engine.lastEventType != SDL_EVENT_KEY_DOWN) return;
+	SDL_Keycode key = engine.lastKeyboardEvent.key;
+
+	if (onSearch) {
+		if (key == SDLK_ESCAPE) {
+			onSearch = false;
+			searchString = "";
+		} else if (key == SDLK_KP_ENTER || key == SDLK_RETURN) {
+			onSearch = false;
+			matchLine = -1;
+			search(true);
+		} else if (key == SDLK_BACKSPACE) {
+			if (!searchString.empty()) searchString.pop_back();
+		} else if (
+			((key >= SDLK_A && key <= SDLK_Z) || (key >= SDLK_0 && key <= SDLK_9) || key == SDLK_SPACE) &&
+			searchString.length() < MAX_SEARCH_LENGTH) {
+			searchString.push_back((char)key);
+		}
+		return;
+	}
+
+	switch (key) {
+		case SDLK_ESCAPE:
+		case SDLK_M:
+			closeWithState(Engine::IDLE);
+			return;
+		case SDLK_UP:
+		case SDLK_K:
+			scrollTo(bottomLine - 1);
+			break;
+		case SDLK_DOWN:
+		case SDLK_J:
+			scrollTo(bottomLine + 1);
+			break;
+		case SDLK_PAGEUP:
+			scrollTo(bottomLine - PAGE_LINES);
+			break;
+		case SDLK_PAGEDOWN:
+			scrollTo(bottomLine + PAGE_LINES);
+			break;
+		case SDLK_HOME:
+			scrollTo(0);
+			break;
+		case SDLK_END:
+			scrollTo(engine.gui->getHistorySize());
+			break;
+		case SDLK_SLASH:
+			onSearch = true;
+			searchString = "";
+			break;
+		case SDLK_N:
+			// n finds an older match, N a newer one
+			search(!(engine.lastKeyboardEvent.mod & SDL_KMOD_SHIFT));
+			break;
+		default:
+			break;
+	}
+}
+
+void HistoryMenu::render(tcod::Console& mainConsole) {
+	historyConsole.clear();
+	int size = engine.gui->getHistorySize();
+	scrollTo(bottomLine);
+	tcod::print(
+		historyConsole,
+		{0, 0},
+		tcod::stringf("Message history: %d lines, %zu KB", size, engine.gui->getHistoryMemoryUsage() / 1024),
+		WHITE,
+		std::nullopt);
+
+	int firstLine = std::max(0, bottomLine - PAGE_LINES);
+	for (int i = firstLine; i < bottomLine; i++) {
+		char buffer[Gui::LINE_BUFFER_SIZE];
+		tcod::ColorRGB color;
+		int count;
+		std::string_view text = engine.gui->getHistoryLine(i, buffer, sizeof(buffer), color, count);
+		std::string line = count > 1 ? tcod::stringf("%.*s (x%d)", (int)text.size(), text.data(), count)
+									 : std::string(text);
+		std::optional<tcod::ColorRGB> background = std::nullopt;
+		if (i == matchLine) background = DARKER_BLUE;
+		tcod::print(historyConsole, {0, 1 + i - firstLine}, line, color, background);
+	}
+
+	std::string help = onSearch ? "Search: " + searchString + "_"
+						: searchString.empty() ? "Scroll - jk PgUp PgDn Home End    Search - /    Close - Esc"
+											   : "Next match - n    Previous match - N    Search - /    Close - Esc";
+	tcod::print(historyConsole, {0, HISTORY_HEIGHT - 1}, help, LIGHT_GREY, std::nullopt);
+
+	tcod::blit(
+		mainConsole,
+		historyConsole,
+		{engine.CONSOLE_WIDTH / 2 - HISTORY_WIDTH / 2, engine.CONSOLE_HEIGHT / 2 - HISTORY_HEIGHT / 2},
+		{0, 0, HISTORY_WIDTH, HISTORY_HEIGHT},
+		0.95F,
+		0.8F);
+}
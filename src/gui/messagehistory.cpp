@@ -0,0 +1,89 @@
+#include "gui/messagehistory.hpp"
+
+#include <zlib.h>
+
+#include <cassert>
+#include <cstring>
+
+#include "main.hpp"
+
+static constexpr size_t LINE_HEADER_SIZE = 8;
+
+MessageHistory::MessageHistory(bool isCompressed) : isCompressed(isCompressed), nbLines(0), decodedIndex(-1) {}
+
+void MessageHistory::add(std::string_view text, const tcod::ColorRGB& color, int count) {
+	text = text.substr(0, 255);
+	uint8_t header[LINE_HEADER_SIZE] = {color.r, color.g, color.b, 0, 0, 0, 0, (uint8_t)text.size()};
+	uint32_t lineCount = (uint32_t)count;
+	std::memcpy(header + 3, &lineCount, sizeof(lineCount));
+	openOffsets.push_back((uint32_t)openChunk.size());
+	openChunk.insert(openChunk.end(), header, header + LINE_HEADER_SIZE);
+	openChunk.insert(openChunk.end(), text.begin(), text.end());
+	nbLines++;
+	if ((int)openOffsets.size() == LINES_PER_CHUNK) sealOpenChunk();
+}
+
+// Move the open chunk to the full chunks, compressing it if that saves space
+void MessageHistory::sealOpenChunk() {
+	Chunk chunk = {{}, (uint32_t)openChunk.size(), false};
+	if (isCompressed) {
+		uLongf compressedSize = compressBound((uLong)openChunk.size());
+		chunk.data.resize(compressedSize);
+		if (compress2(chunk.data.data(), &compressedSize, openChunk.data(), (uLong)openChunk.size(), 6) == Z_OK &&
+			compressedSize < openChunk.size()) {
+			chunk.data.resize(compressedSize);
+			chunk.data.shrink_to_fit();
+			chunk.isCompressed = true;
+		}
+	}
+	if (!chunk.isCompressed) chunk.data = openChunk;
+	chunks.push_back(std::move(chunk));
+	openChunk.clear();
+	openOffsets.clear();
+}
+
+MessageHistory::Line MessageHistory::decodeLine(const uint8_t* line) {
+	uint32_t count;
+	std::memcpy(&count, line + 3, sizeof(count));
+	return {
+		std::string_view(reinterpret_cast<const char*>(line + LINE_HEADER_SIZE), line[7]),
+		tcod::ColorRGB{line[0], line[1], line[2]},
+		(int)count};
+}
+
+MessageHistory::Line MessageHistory::get(int index) {
+	assert(index >= 0 && index < nbLines);
+	int chunkIndex = index / LINES_PER_CHUNK;
+	int lineIndex = index % LINES_PER_CHUNK;
+	if (chunkIndex == (int)chunks.size()) return decodeLine(openChunk.data() + openOffsets[lineIndex]);
+
+	if (chunkIndex != decodedIndex) {
+		const Chunk& chunk = chunks[chunkIndex];
+		if (chunk.isCompressed) {
+			decodedChunk.resize(chunk.rawSize);
+			uLongf rawSize = chunk.rawSize;
+			// A chunk that does not inflate back to its size has no lines rather than garbage ones
+			if (uncompress(decodedChunk.data(), &rawSize, chunk.data.data(), (uLong)chunk.data.size()) != Z_OK ||
+				rawSize != chunk.rawSize)
+				decodedChunk.clear();
+		} else {
+			decodedChunk = chunk.data;
+		}
+		decodedOffsets.clear();
+		for (size_t offset = 0; offset + LINE_HEADER_SIZE <= decodedChunk.size();) {
+			size_t end = offset + LINE_HEADER_SIZE + decodedChunk[offset + 7];
+			if (end > decodedChunk.size()) break;
+			decodedOffsets.push_back((uint32_t)offset);
+			offset = end;
+		}
+		decodedIndex = chunkIndex;
+	}
+	if ((size_t)lineIndex >= decodedOffsets.size()) return {{}, {}, 0};
+	return decodeLine(decodedChunk.data() + decodedOffsets[lineIndex]);
+}
+
+size_t MessageHistory::getMemoryUsage() const {
+	size_t bytes = openChunk.capacity() + openOffsets.capacity() * sizeof(uint32_t);
+	for (const auto& chunk : chunks) bytes += sizeof(chunk) + chunk.data.capacity();
+	return bytes;
+}
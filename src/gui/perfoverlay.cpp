@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include "main.hpp"
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAS_MALLINFO2
+#elif defined(__EMSCRIPTEN__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+static constexpr auto WHITE = tcod::ColorRGB{255, 255, 255};
+static constexpr auto LIGHT_GREY = tcod::ColorRGB{159, 159, 159};
+static constexpr auto LIGHT_RED = tcod::ColorRGB{255, 63, 63};
+static constexpr auto LIGHT_GREEN = tcod::ColorRGB{63, 255, 63};
+
+// Unicode lower half block and full block, as tcod takes codepoints
+static constexpr int HALF_BLOCK = 0x2584;
+static constexpr int FULL_BLOCK = 0x2588;
+
+void PerfOverlay::History::add(float value) {
+	values[next] = value;
+	next = (next + 1) % HISTORY_SIZE;
+	size = std::min(size + 1, HISTORY_SIZE);
+}
+
+float PerfOverlay::History::max() const {
+	float result = 0.0F;
+	for (int i = 0; i < size; i++) result = std::max(result, get(i));
+	return result;
+}
+
+void PerfOverlay::toggle() {
+	isVisible = !isVisible;
+	turnNs = 0;
+}
+
+void PerfOverlay::endTurn() {
+	if (isVisible) turnMs.add(turnNs / 1e6F);
+	turnNs = 0;
+	lastTurn = counters;
+	counters = {};
+}
+
+void PerfOverlay::endFrame(Uint64 frameNs) {
+	if (isVisible) frameMs.add(frameNs / 1e6F);
+}
+
+void PerfOverlay::render(tcod::Console& console, int x, int y) const {
+	tcod::print(console, {x, y}, tcod::stringf("frame %5.1f ms", frameMs.last()), WHITE, std::nullopt);
+	tcod::print(console, {x, y + 1}, tcod::stringf("  max %5.1f", frameMs.max()), LIGHT_GREY, std::nullopt);
+	renderSparkline(console, x + 15, y, frameMs);
+	tcod::print(console, {x, y + 2}, tcod::stringf("turn  %5.1f ms", turnMs.last()), WHITE, std::nullopt);
+	tcod::print(console, {x, y + 3}, tcod::stringf("  max %5.1f", turnMs.max()), LIGHT_GREY, std::nullopt);
+	renderSparkline(console, x + 15, y + 2, turnMs);
+
+	tcod::print(
+		console,
+		{x, y + 4},
+		tcod::stringf(
+			"paths %llu  nodes %llu  fov %llu",
+			(unsigned long long)lastTurn.pathSearches,
+			(unsigned long long)lastTurn.nodesExpanded,
+			(unsigned long long)lastTurn.fovComputes),
+		WHITE,
+		std::nullopt);
+	int monsters = 0, items = 0, corpses = 0;
+	for (auto actor : engine.actors) {
+		if (actor->pickable)
+			items++;
+		else if (actor->destructible && actor->destructible->isDead())
+			corpses++;
+		else if (actor->destructible && actor != engine.player)
+			monsters++;
+	}
+	tcod::print(
+		console,
+		{x, y + 5},
+		tcod::stringf(
+			"actors %d  monsters %d  items %d  corpses %d", (int)engine.actors.size(), monsters, items, corpses),
+		WHITE,
+		std::nullopt);
+	long long heapBytes = getHeapBytes();
+	std::string heap = heapBytes < 0 ? "heap n/a" : tcod::stringf("heap %.1f MB", heapBytes / (1024.0 * 1024.0));
+	tcod::print(console, {x, y + 6}, heap, WHITE, std::nullopt);
+}
+
+void PerfOverlay::renderSparkline(tcod::Console& console, int x, int y, const History& history) {
+	float max = history.max();
+	if (history.size == 0 || max <= 0.0F) return;
+	std::array<float, HISTORY_SIZE> sorted = history.values;
+	std::sort(sorted.begin(), sorted.begin() + history.size);
+	float median = sorted[history.size / 2];
+	// Right aligned, the newest sample in the last column
+	int left = x + HISTORY_SIZE - history.size;
+	for (int i = 0; i < history.size; i++) {
+		float value = history.get(i);
+		// Four half rows, any sample above 0 shows
+		int level = std::clamp((int)(value / max * 4.0F + 0.5F), value > 0.0F ? 1 : 0, 4);
+		auto color = value > 2.0F * median ? LIGHT_RED : LIGHT_GREEN;
+		if (!console.in_bounds({left + i, y + 1})) continue;
+		if (level > 2) {
+			console.at({left + i, y}).ch = level == 4 ? FULL_BLOCK : HALF_BLOCK;
+			console.at({left + i, y}).fg = color;
+		}
+		if (level > 0) {
+			console.at({left + i, y + 1}).ch = level >= 2 ? FULL_BLOCK : HALF_BLOCK;
+			console.at({left + i, y + 1}).fg = color;
+		}
+	}
+}
+
+long long PerfOverlay::getHeapBytes() {
+#if defined(HAS_MALLINFO2)
+	return (long long)mallinfo2().uordblks;
+#elif defined(__EMSCRIPTEN__)
+	return (long long)mallinfo().uordblks;
+#elif defined(__APPLE__)
+	malloc_statistics_t stats;
+	malloc_zone_statistics(NULL, &stats);
+	return (long long)stats.size_in_use;
+#else
+	return -1;
+#endif
+}
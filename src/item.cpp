@@ -1,199 +1,111 @@
 #include "main.hpp"
 
-static auto constexpr LIGHT_YELLOW = tcod::ColorRGB{255, 255, 63};
 static auto constexpr VIOLET = tcod::ColorRGB{127, 0, 255};
 
 Actor* Item::newItem(int x, int y) {
 	Actor* item = new Actor(x, y, '!', "ITEM!", VIOLET);
 	item->blocks = false;
-	engine.actors.push_back(item);
+	engine.addActor(item);
 	// Items visuals should be at the back to not hide actors standing over them
 	engine.sendToBack(item);
 	return item;
 }
 
-void Item::setRandomItem(Actor* item) {
-	int dice = Random::instance().getInt(0, 100);
-	if (dice <= 40) {
-		setRandomPotion(item);
-	} else {
-		setRandomScroll(item);
-	}
-}
+// Indexed by Kind, names of the kinds in data/items.txt
+static constexpr const char* KIND_NAMES[Item::NB_KINDS] = {
+	"Potion of Full Healing",
+	"Potion of Strength",
+	"Potion of Protection",
+	"Potion of Poison",
+	"Potion of Amnesia",
+	"Potion of Confusion",
+	"Potion of Fire",
+	"Scroll of Identify",
+	"Scroll of Teleportation",
+	"Scroll of Mapping",
+	"Scroll of Confusion",
+	"Scroll of Fireball",
+	"Scroll of Liquify",
+	"Scroll of Summon Monsters",
+};
+
+void Item::setRandomItem(Actor* item) { setItem(item, (Kind)Content::get().itemTable.sample(Random::instance())); }
+
+const Item::Prototype& Item::getPrototype(Kind kind) {
+	// Built on first use and never freed. Looks come from data/items.txt, behaviors from the code. Pickables, selectors
+	// and effects hold no per item state, so they are shared by the games of every thread.
+	static const auto PROTOTYPES = [] {
+		// Indexed by Kind
+		Pickable* pickables[NB_KINDS] = {
+			new Pickable(
+				new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
+				new SequentialEffect(
+					new PutOutFireEffect(),
+					new HealthEffect(800, 10, "%s used the healing potion and recovered %g HP!"))),
+			new Pickable(
+				new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
+				new SequentialEffect(new PutOutFireEffect(), new PowerChangeEffect(10))),
+			new Pickable(
+				new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
+				new SequentialEffect(
+					new PutOutFireEffect(), new HealthEffect(0, 25, "%s used the potion and increased %g max HP!"))),
+			new Pickable(
+				new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
+				new SequentialEffect(new PutOutFireEffect(), new PowerChangeEffect(-15))),
+			new Pickable(
+				new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
+				new SequentialEffect(new PutOutFireEffect(), new AmnesiaEffect())),
+			new Pickable(
+				new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
+				new SequentialEffect(new PutOutFireEffect(), new ConfusionEffect())),
+			new Pickable(new TargetSelector(TargetSelector::WEARER_HIMSELF, 0), new SetOnFireEffect(20, 5.0F)),
+			new Pickable(new TargetSelector(TargetSelector::OTHER_ITEM_FROM_INVENTORY, 0), new IdentifyEffect()),
+			new ScrollOfTeleportationPickable(),
+			new Pickable(new TargetSelector(TargetSelector::WEARER_HIMSELF, 0), new MappingEffect()),
+			new Pickable(new TargetSelector(TargetSelector::ROOM_OR_AROUND, 0), new ConfusionEffect()),
+			new Pickable(new TargetSelector(TargetSelector::SELECTED_RANGE, 1.5F), new SetOnFireEffect(10, 10.0F)),
+			new Pickable(new TargetSelector(TargetSelector::OTHER_ITEM_FROM_INVENTORY, 0), new LiquifyEffect()),
+			new Pickable(new TargetSelector(TargetSelector::WEARER_HIMSELF, 0), new SummonMonsterEffect()),
+		};
+		const Content& content = Content::get();
+		std::array<Prototype, NB_KINDS> prototypes;
+		for (int i = 0; i < NB_KINDS; i++) {
+			const Content::ItemKind& item = content.items[i];
+			prototypes[i] = {content.getString(item.name), item.ch, {item.r, item.g, item.b}, pickables[i]};
+		}
+		return prototypes;
+	}();
+	return PROTOTYPES[kind];
+}
+
+void Item::setItem(Actor* item, Kind kind) {
+	const Prototype& prototype = getPrototype(kind);
+	item->ch = prototype.ch;
+	item->name = prototype.name;
+	item->color = prototype.color;
+	item->pickable = prototype.pickable;
+	item->itemKind = kind;
+}
+
+bool Item::setItemByName(Actor* item, const char* name) {
+	Kind kind = getKindByName(name);
+	if (kind == NO_KIND) return false;
+	setItem(item, kind);
+	return true;
+}
+
+Item::Kind Item::getKindByName(std::string_view name) {
+	for (int kind = 0; kind < NB_KINDS; kind++)
+		if (name == KIND_NAMES[kind]) return (Kind)kind;
+	return NO_KIND;
+}
+
+const char* Item::getName(Kind kind) { return KIND_NAMES[kind]; }
 
 void Item::setRandomPotion(Actor* item) {
-	int potionIndex = Random::instance().getInt(0, 10);
-	switch (potionIndex) {
-		case 0:
-		case 7:
-		case 8:
-		case 9:
-			setPotionOfFullHealing(item);
-			break;
-		case 1:
-			setPotionOfStrength(item);
-			break;
-		case 2:
-		case 10:
-			setPotionOfProtection(item);
-			break;
-		case 3:
-			setPotionOfPoison(item);
-			break;
-		case 4:
-			setPotionOfAmnesia(item);
-			break;
-		case 5:
-			setPotionOfConfusion(item);
-			break;
-		case 6:
-			setPotionOfFire(item);
-			break;
-	}
+	setItem(item, (Kind)(FIRST_POTION + Content::get().potionTable.sample(Random::instance())));
 }
 
 void Item::setRandomScroll(Actor* item) {
-	int scrollIndex = Random::instance().getInt(0, 10);
-	switch (scrollIndex) {
-		case 0:
-			setScrollOfIdentify(item);
-			break;
-		case 1:
-		case 7:
-		case 9:
-			setScrollOfTeleportation(item);
-			break;
-		case 2:
-			setScrollOfMapping(item);
-			break;
-		case 3:
-		case 10:
-			setScrollOfConfusion(item);
-			break;
-		case 4:
-			setScrollOfFireball(item);
-			break;
-		case 5:
-		case 8:
-			setScrollOfLiquify(item);
-			break;
-		case 6:
-			setScrollOfSummonMonsters(item);
-			break;
-	}
-}
-
-void Item::setPotionOfFullHealing(Actor* item) {
-	item->ch = '!';
-	item->name = "Potion of Full Healing";
-	item->color = VIOLET;
-	item->pickable = new Pickable(
-		new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
-		new SequentialEffect(
-			new PutOutFireEffect(), new HealthEffect(800, 10, "%s used the healing potion and recovered %g HP!")));
-}
-
-void Item::setPotionOfStrength(Actor* item) {
-	item->ch = '!';
-	item->name = "Potion of Strength";
-	item->color = VIOLET;
-	item->pickable = new Pickable(
-		new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
-		new SequentialEffect(new PutOutFireEffect(), new PowerChangeEffect(10)));
-}
-
-void Item::setPotionOfProtection(Actor* item) {
-	item->ch = '!';
-	item->name = "Potion of Protection";
-	item->color = VIOLET;
-	item->pickable = new Pickable(
-		new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
-		new SequentialEffect(
-			new PutOutFireEffect(), new HealthEffect(0, 25, "%s used the potion and increased %g max HP!")));
-}
-
-void Item::setPotionOfPoison(Actor* item) {
-	item->ch = '!';
-	item->name = "Potion of Poison";
-	item->color = VIOLET;
-	item->pickable = new Pickable(
-		new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
-		new SequentialEffect(new PutOutFireEffect(), new PowerChangeEffect(-15)));
-}
-
-void Item::setPotionOfAmnesia(Actor* item) {
-	item->ch = '!';
-	item->name = "Potion of Amnesia";
-	item->color = VIOLET;
-	item->pickable = new Pickable(
-		new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
-		new SequentialEffect(new PutOutFireEffect(), new AmnesiaEffect()));
-}
-
-void Item::setPotionOfConfusion(Actor* item) {
-	item->ch = '!';
-	item->name = "Potion of Confusion";
-	item->color = VIOLET;
-	item->pickable = new Pickable(
-		new TargetSelector(TargetSelector::WEARER_HIMSELF, 0),
-		new SequentialEffect(new PutOutFireEffect(), new ConfusionEffect()));
-}
-
-void Item::setPotionOfFire(Actor* item) {
-	item->ch = '!';
-	item->name = "Potion of Fire";
-	item->color = VIOLET;
-	item->pickable = new Pickable(new TargetSelector(TargetSelector::WEARER_HIMSELF, 0), new SetOnFireEffect(20, 5.0F));
-}
-
-void Item::setScrollOfIdentify(Actor* item) {
-	item->ch = '?';
-	item->name = "Scroll of Identify";
-	item->color = LIGHT_YELLOW;
-	item->pickable =
-		new Pickable(new TargetSelector(TargetSelector::OTHER_ITEM_FROM_INVENTORY, 0), new IdentifyEffect());
-}
-
-void Item::setScrollOfTeleportation(Actor* item) {
-	item->ch = '?';
-	item->name = "Scroll of Teleportation";
-	item->color = LIGHT_YELLOW;
-	item->pickable = new ScrollOfTeleportationPickable();
-}
-
-void Item::setScrollOfMapping(Actor* item) {
-	item->ch = '?';
-	item->name = "Scroll of Mapping";
-	item->color = LIGHT_YELLOW;
-	item->pickable = new Pickable(new TargetSelector(TargetSelector::WEARER_HIMSELF, 0), new MappingEffect());
-}
-
-void Item::setScrollOfConfusion(Actor* item) {
-	item->ch = '?';
-	item->name = "Scroll of Confusion";
-	item->color = LIGHT_YELLOW;
-	item->pickable = new Pickable(new TargetSelector(TargetSelector::ROOM_OR_AROUND, 0), new ConfusionEffect());
-}
-
-void Item::setScrollOfFireball(Actor* item) {
-	item->ch = '?';
-	item->name = "Scroll of Fireball";
-	item->color = LIGHT_YELLOW;
-	item->pickable =
-		new Pickable(new TargetSelector(TargetSelector::SELECTED_RANGE, 1.5F), new SetOnFireEffect(10, 10.0F));
-}
-
-void Item::setScrollOfLiquify(Actor* item) {
-	item->ch = '?';
-	item->name = "Scroll of Liquify";
-	item->color = LIGHT_YELLOW;
-	item->pickable =
-		new Pickable(new TargetSelector(TargetSelector::OTHER_ITEM_FROM_INVENTORY, 0), new LiquifyEffect());
-}
-
-void Item::setScrollOfSummonMonsters(Actor* item) {
-	item->ch = '?';
-	item->name = "Scroll of Summon Monsters";
-	item->color = LIGHT_YELLOW;
-	item->pickable = new Pickable(new TargetSelector(TargetSelector::WEARER_HIMSELF, 0), new SummonMonsterEffect());
+	setItem(item, (Kind)(FIRST_SCROLL + Content::get().scrollTable.sample(Random::instance())));
 }
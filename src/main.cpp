@@ -4,8 +4,6 @@
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
-Engine engine;
-
 SDL_AppResult SDL_AppInit(void**, int argc, char** argv) { return engine.init(argc, argv); }
 
 SDL_AppResult SDL_AppIterate(void*) { return engine.iterate(); }
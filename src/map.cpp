@@ -1,110 +1,112 @@
+#include <bit>
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
 #include <queue>
 
 #include "main.hpp"
 
-static const int ROOM_MAX_SIZE = 12;
-static const int ROOM_MIN_SIZE = 4;
-
-static constexpr int MAX_ID_SCROLL_BY_FLOOR[20] = {7, 6, 2, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-static constexpr int MIN_TOTAL_ITEMS_BY_FLOOR[20] = {14, 12, 10, 7, 7, 5, 5, 5, 5, 4, 4, 4, 7, 4, 4, 7, 4, 4, 4, 4};
-static constexpr int MAX_TOTAL_ITEMS_BY_FLOOR[20] = {14, 12, 10, 9, 8, 7, 6, 6, 6, 6, 6, 6, 9, 6, 6, 9, 6, 6, 6, 6};
-static constexpr int ENEMY_DENSITY_BY_FLOOR[20] = {1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3};
-static constexpr float EASY_LAYOUT_CHANCE_BY_FLOOR[20] = {0.1, 0.1, 0.1, 0.1, 0.1, 0.1, 0.1, 0.1, 0.1, 0.1,
-														  0.1, 0.1, 0.7, 0.5, 0.5, 0.9, 0.5, 0.5, 0.8, 0.0};
-
 static auto constexpr LIGHT_YELLOW = tcod::ColorRGB{255, 255, 63};
 static auto constexpr VIOLET = tcod::ColorRGB{127, 0, 255};
 
-// Bsp Listener class for randomly creating rooms in the Bsp tree algorithm
-class BspListener : public ITCODBspCallback {
-   private:
-	Map& map;  // a map to dig
-	int roomNum;  // room number
-	int lastx, lasty;  // center of the last room
-   public:
-	BspListener(Map& map) : map(map), roomNum(0) {}
-	bool visitNode(TCODBsp* node, void* userData) {
-		if (node->isLeaf()) {
-			int x, y, w, h;
-			// dig a room
-			Random& rng = Random::instance();
-			w = rng.getInt(ROOM_MIN_SIZE, node->w - 2);
-			h = rng.getInt(ROOM_MIN_SIZE, node->h - 2);
-			x = rng.getInt(node->x + 1, node->x + node->w - w - 1);
-			y = rng.getInt(node->y + 1, node->y + node->h - h - 1);
-			map.createRoom(roomNum == 0, x, y, x + w - 1, y + h - 1);
-			if (roomNum != 0) {
-				// dig a corridor from last room
-				map.dig(lastx, lasty, x + w / 2, lasty);
-				map.dig(x + w / 2, lasty, x + w / 2, y + h / 2);
-			}
-			lastx = x + w / 2;
-			lasty = y + h / 2;
-			roomNum++;
-		}
-		return true;
-	}
-};
+// Floor contents are given for a default size floor, larger floors get as many per tile
+static int scaleToArea(int count, const Map& map) {
+	return (int)((long long)count * map.width * map.height / (Engine::MAP_WIDTH * Engine::MAP_HEIGHT));
+}
+
+MapChunk::MapChunk() {
+	for (auto& layer : layers) std::fill(std::begin(layer), std::end(layer), 0);
+	std::fill(std::begin(roomIds), std::end(roomIds), Map::NO_ROOM);
+}
 
 // Create map with (width, height), so x < width and y < height. Players are already created
-Map::Map(int width, int height)
-	: width(width),
-	  height(height),
-	  isMapRevealed(false),
-	  isEasyLayout(Random::instance().getBool(EASY_LAYOUT_CHANCE_BY_FLOOR[engine.level - 1])) {
-	roomRecords.clear();
-	tiles = new Tile[width * height];
-	map = new TCODMap(width, height);
-
-	TCODBsp bsp(0, 0, width, height);
-	bsp.splitRecursive(NULL, 8, ROOM_MAX_SIZE, ROOM_MAX_SIZE, 1.5f, 1.5f);
-	BspListener listener(*this);
-	bsp.traverseInvertedLevelOrder(&listener, NULL);
+// If generate is false the map is left as solid rock, to be filled in by the caller (e.g. when loading a save)
+Map::Map(int width, int height, bool generate)
+	: width(width), height(height), isMapRevealed(false), isEasyLayout(false), fovMap(NULL), fovX(0), fovY(0) {
+	assert(width > 0 && width <= MAX_SIZE && height > 0 && height <= MAX_SIZE);
+	rooms.clear();
+	corridorRecords.clear();
+	chunksWidth = (width + MapChunk::SIZE - 1) / MapChunk::SIZE;
+	chunksHeight = (height + MapChunk::SIZE - 1) / MapChunk::SIZE;
+	chunks.assign(chunksWidth * chunksHeight, NULL);
+	if (!generate) return;
+	const Content::Floor& floor = Content::get().getFloor(engine.level);
+	isEasyLayout = Random::instance().getBool(floor.easyLayoutChance);
+
+	MapGenerator::Kind kind = engine.mapGenerator;
+	if (kind == MapGenerator::NB_KINDS) kind = (MapGenerator::Kind)floor.generators.sample(Random::instance());
+	auto start = std::chrono::steady_clock::now();
+	MapGenerator* generator = MapGenerator::create(kind);
+	generator->generate(*this);
+	delete generator;
+	double generateUs = elapsedUs(start);
+	connectAndPlaceStairs();
+	layoutStats.generator = kind;
+	layoutStats.generateUs = generateUs;
+	indexRooms();
+	engine.freeTiles.build(*this, engine.actors);
 
 	addItems();
 	addMonsters();
 }
 
+bool Map::parseSize(const char* text, int& width, int& height) {
+	int parsedWidth, parsedHeight;
+	if (std::sscanf(text, "%dx%d", &parsedWidth, &parsedHeight) != 2) return false;
+	if (parsedWidth < MIN_SIZE || parsedWidth > MAX_SIZE || parsedHeight < MIN_SIZE || parsedHeight > MAX_SIZE)
+		return false;
+	width = parsedWidth;
+	height = parsedHeight;
+	return true;
+}
+
 // Destructor
 Map::~Map() {
-	delete[] tiles;
-	delete map;
+	for (auto chunk : chunks) delete chunk;
+	delete fovMap;
 }
 
-// Is tile walkable
-bool Map::isWalkable(int x, int y) const { return map->isWalkable(x, y); }
+MapChunk& Map::makeChunk(int x, int y) {
+	MapChunk*& chunk = chunks[x / MapChunk::SIZE + y / MapChunk::SIZE * chunksWidth];
+	if (!chunk) chunk = new MapChunk();
+	return *chunk;
+}
+
+void Map::setFlags(int x, int y, uint8_t flags) {
+	// Rock stays unallocated
+	if (flags == 0 && !getChunk(x, y)) return;
+	makeChunk(x, y).setFlags(x % MapChunk::SIZE, y % MapChunk::SIZE, flags);
+}
 
 // Is both tile walkable and no blocking actors are present
 bool Map::canWalk(int x, int y) const {
 	if (!isWalkable(x, y)) return false;
-	for (auto actor : engine.actors)
-		if (actor->x == x && actor->y == y && actor->blocks) return false;
-	return true;
+	bool isBlocked = false;
+	engine.spatialIndex.forEachInRect(x, y, x, y, [&](Actor* actor) { isBlocked |= actor->blocks; });
+	return !isBlocked;
 }
 
 // Set tile to be walkable
 void Map::setWalkable(int x, int y, bool newWalkableValue) {
-	map->setProperties(x, y, map->isTransparent(x, y), newWalkableValue);
+	uint8_t flags = getFlags(x, y) & ~TILE_WALKABLE;
+	setFlags(x, y, newWalkableValue ? flags | TILE_WALKABLE : flags);
+	if (engine.map == this) engine.freeTiles.setWalkable(x, y, newWalkableValue);
 }
 
-// Has the tile been explored by the player before
-bool Map::isExplored(int x, int y) const { return tiles[x + y * width].explored; }
-
 // Find spots near (x, y) that are empty and not blocked. If none find, {-1, -1} is returned
 std::array<int, 2> Map::findSpotsNear(int x, int y) {
 	std::vector<std::pair<std::pair<int, int>, std::array<int, 2>>> candidates = {};
 	Random& rng = Random::instance();
+	bool hasBlocker[7][7] = {};
+	engine.spatialIndex.forEachInRect(x - 3, y - 3, x + 3, y + 3, [&](Actor* actor) {
+		if (actor->blocks) hasBlocker[actor->x - x + 3][actor->y - y + 3] = true;
+	});
 	for (int dx = -3; dx <= 3; dx++)
 		for (int dy = -3; dy <= 3; dy++) {
 			int cx = x + dx, cy = y + dy;
-			bool hasBlocker = false;
-			for (auto actor : engine.actors)
-				if (actor->x == cx && actor->y == cy && actor->blocks) {
-					hasBlocker = true;
-					break;
-				}
-			if (map->isWalkable(cx, cy) && !hasBlocker) {
+			if (isWalkable(cx, cy) && !hasBlocker[dx + 3][dy + 3]) {
 				candidates.push_back({{(cx - x) * (cx - x) + (cy - y) * (cy - y), rng.getInt(0, 10000)}, {cx, cy}});
 			}
 		}
@@ -113,38 +115,104 @@ std::array<int, 2> Map::findSpotsNear(int x, int y) {
 	return candidates[0].second;
 }
 
-// Is the tile in FoV, but computeFov() must be called first
-bool Map::isInFov(int x, int y) const {
-	if (x < 0 || x >= width || y < 0 || y >= height) {
-		return false;
+void Map::getTiles(TileFlag flag, BitBoard& tiles) const {
+	int layer = std::countr_zero((unsigned)flag);
+	for (int row = 0; row < tiles.getHeight(); row++) {
+		int y = tiles.getY() + row;
+		uint64_t* words = tiles.rowWords(row);
+		for (int w = 0; w < tiles.getNbWords(); w++) {
+			// The 64 tiles from x straddle at most two chunks
+			int x = tiles.getX() + w * 64;
+			int chunkX = x >= 0 ? x / MapChunk::SIZE : -((MapChunk::SIZE - 1 - x) / MapChunk::SIZE);
+			int shift = x - chunkX * MapChunk::SIZE;
+			uint64_t word = getChunkRow(layer, chunkX, y) >> shift;
+			if (shift) word |= getChunkRow(layer, chunkX + 1, y) << (64 - shift);
+			words[w] = word;
+		}
+		tiles.clipRow(row);
 	}
-	if (map->isInFov(x, y)) {
-		tiles[x + y * width].explored = true;
-		return true;
+}
+
+void Map::addTiles(TileFlag flag, const BitBoard& tiles) {
+	int layer = std::countr_zero((unsigned)flag);
+	for (int row = 0; row < tiles.getHeight(); row++) {
+		int y = tiles.getY() + row;
+		const uint64_t* words = tiles.rowWords(row);
+		for (int w = 0; w < tiles.getNbWords(); w++) {
+			if (!words[w]) continue;
+			// Tiles of the board are on the map, and the 64 from x straddle at most two chunks
+			int x = tiles.getX() + w * 64;
+			int shift = x % MapChunk::SIZE;
+			makeChunk(x, y).layers[layer][y % MapChunk::SIZE] |= words[w] << shift;
+			uint64_t rest = shift ? words[w] >> (64 - shift) : 0;
+			if (rest) makeChunk(x + 64 - shift, y).layers[layer][y % MapChunk::SIZE] |= rest;
+		}
 	}
-	return false;
 }
 
-// Compute new FoV based on fovRadius set in Engine, quite expensive
-void Map::computeFov() { map->computeFov(engine.player->x, engine.player->y, engine.fovRadius); }
+// Compute new FoV based on fovRadius set in Engine. Tiles further than that can not be seen, so only the square
+// around the player is copied to fovMap, clipped to the map like a full size TCODMap would. What is seen is marked
+// explored here, a word of the FoV board at a time.
+void Map::computeFov() {
+	engine.perfOverlay.counters.fovComputes++;
+	int playerX = engine.player->x, playerY = engine.player->y, radius = engine.fovRadius;
+	int x1 = std::max(0, playerX - radius), x2 = std::min(width - 1, playerX + radius);
+	int y1 = std::max(0, playerY - radius), y2 = std::min(height - 1, playerY + radius);
+	if (x1 > x2 || y1 > y2) {
+		// Player is off the map, nothing is seen
+		delete fovMap;
+		fovMap = NULL;
+		fov.reset(0, 0, 0, 0);
+		return;
+	}
+	if (!fovMap || fovMap->getWidth() != x2 - x1 + 1 || fovMap->getHeight() != y2 - y1 + 1) {
+		delete fovMap;
+		fovMap = new TCODMap(x2 - x1 + 1, y2 - y1 + 1);
+	}
+	fovX = x1;
+	fovY = y1;
+	for (int y = y1; y <= y2; y++)
+		for (int x = x1; x <= x2; x++) {
+			uint8_t flags = getFlags(x, y);
+			fovMap->setProperties(x - x1, y - y1, flags & TILE_TRANSPARENT, flags & TILE_WALKABLE);
+		}
+	fovMap->computeFov(playerX - x1, playerY - y1, radius);
+	fov.reset(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+	for (int y = y1; y <= y2; y++)
+		for (int x = x1; x <= x2; x++)
+			if (fovMap->isInFov(x - x1, y - y1)) fov.set(x, y);
+	addTiles(TILE_EXPLORED, fov);
+}
 
-// Draw map background tiles on the console
-void Map::render(tcod::Console& console) const {
+// Draw map background tiles on the console, only visiting the chunks the view overlaps
+void Map::render(tcod::Console& console, int viewX, int viewY) const {
 	static const TCOD_color_t darkWall = {0, 0, 100};
 	static const TCOD_color_t darkGround = {70, 40, 30};
 	static const TCOD_color_t lightWall = {130, 110, 150};
 	static const TCOD_color_t lightGround = {200, 130, 50};
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-			if (console.in_bounds({x, y})) {
-				if (isInFov(x, y)) {
-					console[{x, y}].bg = isWalkable(x, y) ? lightGround : lightWall;
-				} else if (isExplored(x, y) || isMapRevealed) {
-					console[{x, y}].bg = isWalkable(x, y) ? darkGround : darkWall;
+	int x1 = std::max(0, viewX), x2 = std::min(width, viewX + Engine::VIEW_WIDTH) - 1;
+	int y1 = std::max(0, viewY), y2 = std::min(height, viewY + Engine::VIEW_HEIGHT) - 1;
+	if (x1 > x2 || y1 > y2) return;
+	for (int chunkY = y1 / MapChunk::SIZE; chunkY <= y2 / MapChunk::SIZE; chunkY++)
+		for (int chunkX = x1 / MapChunk::SIZE; chunkX <= x2 / MapChunk::SIZE; chunkX++) {
+			const MapChunk* chunk = chunks[chunkX + chunkY * chunksWidth];
+			// Unexplored rock is only drawn on revealed maps
+			if (!chunk && !isMapRevealed) continue;
+			int tileX1 = std::max(x1, chunkX * MapChunk::SIZE);
+			int tileX2 = std::min(x2, (chunkX + 1) * MapChunk::SIZE - 1);
+			int tileY1 = std::max(y1, chunkY * MapChunk::SIZE);
+			int tileY2 = std::min(y2, (chunkY + 1) * MapChunk::SIZE - 1);
+			for (int y = tileY1; y <= tileY2; y++)
+				for (int x = tileX1; x <= tileX2; x++) {
+					uint8_t flags = chunk ? chunk->getFlags(x % MapChunk::SIZE, y % MapChunk::SIZE) : 0;
+					bool isFloor = flags & TILE_WALKABLE;
+					if (chunk && isInFov(x, y)) {
+						console[{x - viewX, y - viewY}].bg = isFloor ? lightGround : lightWall;
+					} else if (isMapRevealed || (flags & TILE_EXPLORED)) {
+						console[{x - viewX, y - viewY}].bg = isFloor ? darkGround : darkWall;
+					}
 				}
-			}
 		}
-	}
 }
 
 // Dig out a rectangle
@@ -152,134 +220,328 @@ void Map::dig(int x1, int y1, int x2, int y2) {
 	if (x2 < x1) std::swap(x1, x2);
 	if (y2 < y1) std::swap(y1, y2);
 	assert(x1 >= 0 && x2 < width);	// x must be in bounds
-	assert(y1 >= 0 && y2 < width);	// y must be in bounds
+	assert(y1 >= 0 && y2 < height);	// y must be in bounds
 	for (int tilex = x1; tilex <= x2; tilex++) {
 		for (int tiley = y1; tiley <= y2; tiley++) {
-			map->setProperties(tilex, tiley, true, true);
+			setFlags(tilex, tiley, getFlags(tilex, tiley) | TILE_WALKABLE | TILE_TRANSPARENT);
 		}
 	}
 }
 
-// Create a rectangular room, and if first room the player position is set to be there
+// Create a rectangular room, and if first room the player position is set to be there. Stairs are placed once the
+// whole floor is dug, see connectAndPlaceStairs().
 void Map::createRoom(bool first, int x1, int y1, int x2, int y2) {
 	dig(x1, y1, x2, y2);
-	roomRecords.push_back({x1, y1, x2, y2});
+	rooms.push_back({x1, y1, x2, y2, 0, {}});
 	if (first) {
 		// Put the player in the first room
-		engine.player->x = Random::instance().getInt(x1, x2);
-		engine.player->y = Random::instance().getInt(y1, y2);
-		engine.stairs->x = Random::instance().getInt(x1, x2);
-		engine.stairs->y = Random::instance().getInt(y1, y2);
+		int playerX = Random::instance().getInt(x1, x2);
+		engine.player->moveTo(playerX, Random::instance().getInt(y1, y2));
 	}
+}
+
+void Map::connectAndPlaceStairs() {
+	auto start = std::chrono::steady_clock::now();
+	layoutStats = {};
+	// Walking distance of every tile from the player, -1 until reached. Tiles are x + y * width.
+	std::vector<int> distance((size_t)width * height, -1);
+	std::vector<int> queue;
+	auto search = [&](int from) {
+		queue.clear();
+		queue.push_back(from);
+		distance[from] = 0;
+		for (size_t head = 0; head < queue.size(); head++) {
+			int index = queue[head];
+			int x = index % width, y = index / width;
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++) {
+					int nx = x + dx, ny = y + dy;
+					if (!isWalkable(nx, ny) || distance[nx + ny * width] != -1) continue;
+					distance[nx + ny * width] = distance[index] + 1;
+					queue.push_back(nx + ny * width);
+				}
+		}
+	};
+	int playerX = engine.player->x, playerY = engine.player->y;
+	search(playerX + playerY * width);
+	layoutStats.components = 1;
+	layoutStats.farthestDistance = distance[queue.back()];
+
+	// Every other group is searched only to be counted, then filled in
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) {
+			if (!isWalkable(x, y) || distance[x + y * width] != -1) continue;
+			search(x + y * width);
+			layoutStats.components++;
+			layoutStats.filledTiles += (int)queue.size();
+			for (int index : queue) {
+				setFlags(index % width, index / width, 0);
+				distance[index] = -1;
+			}
+		}
+
+	// Reachable room tiles within the band, or failing that the closest to it
+	const Content::Floor& floor = Content::get().getFloor(engine.level);
+	float minFraction = isEasyLayout ? floor.minEasyStairsDistance : floor.minStairsDistance;
+	float maxFraction = isEasyLayout ? floor.maxEasyStairsDistance : floor.maxStairsDistance;
+	int minDistance = (int)std::ceil(minFraction * layoutStats.farthestDistance);
+	int maxDistance = (int)std::floor(maxFraction * layoutStats.farthestDistance);
+	std::vector<int> candidates;
+	int closest = playerX + playerY * width, closestGap = INT_MAX;
+	for (const Room& room : rooms)
+		for (int y = room.y1; y <= room.y2; y++)
+			for (int x = room.x1; x <= room.x2; x++) {
+				int d = distance[x + y * width];
+				// Never on the player, unless there is nowhere else
+				if (d <= 0) continue;
+				int gap = d < minDistance ? minDistance - d : d > maxDistance ? d - maxDistance : 0;
+				if (gap == 0) candidates.push_back(x + y * width);
+				if (gap < closestGap) {
+					closest = x + y * width;
+					closestGap = gap;
+				}
+			}
+	int stairs = candidates.empty() ? closest : candidates[Random::instance().getInt(0, (int)candidates.size() - 1)];
+	engine.stairs->moveTo(stairs % width, stairs / width);
+	layoutStats.stairsDistance = distance[stairs];
+	layoutStats.passUs = elapsedUs(start);
+}
+
+void Map::indexRooms() {
+	for (auto chunk : chunks)
+		if (chunk) std::fill(std::begin(chunk->roomIds), std::end(chunk->roomIds), NO_ROOM);
+	for (int i = 0; i < (int)rooms.size(); i++) {
+		Room& room = rooms[i];
+		room.nbTiles = 0;
+		room.neighbors.clear();
+		for (int y = room.y1; y <= room.y2; y++)
+			for (int x = room.x1; x <= room.x2; x++) {
+				makeChunk(x, y).roomIds[chunkIndex(x, y)] = (uint16_t)i;
+				if (isWalkable(x, y)) room.nbTiles++;
+			}
+	}
+	// Walk every corridor, rooms met one after the other are neighbors
+	for (auto [x1, y1, x2, y2] : corridorRecords) {
+		uint16_t lastRoom = getRoomAt(x1, y1);
+		auto visit = [&](int x, int y) {
+			uint16_t& id = makeChunk(x, y).roomIds[chunkIndex(x, y)];
+			if (id == NO_ROOM) id = CORRIDOR;
+			if (id == CORRIDOR || id == lastRoom) return;
+			if (lastRoom < rooms.size()) {
+				auto& neighbors = rooms[lastRoom].neighbors;
+				if (std::find(neighbors.begin(), neighbors.end(), id) == neighbors.end()) {
+					neighbors.push_back(id);
+					rooms[id].neighbors.push_back(lastRoom);
+				}
+			}
+			lastRoom = id;
+		};
+		// Same path as dug by BspListener, along x first then along y
+		for (int x = x1; x != x2; x += x2 > x1 ? 1 : -1) visit(x, y1);
+		for (int y = y1; y != y2; y += y2 > y1 ? 1 : -1) visit(x2, y);
+		visit(x2, y2);
+	}
+}
+
+void Map::getActorsInRoom(int room, std::vector<Actor*>& actors) const {
+	actors.clear();
+	const Room& bounds = rooms[room];
+	engine.spatialIndex.forEachInRect(bounds.x1, bounds.y1, bounds.x2, bounds.y2, [&](Actor* actor) {
+		actors.push_back(actor);
+	});
+}
+
+bool Map::getRandomFreeTile(int room, int& x, int& y) const {
+	const Room& bounds = rooms[room];
 	Random& rng = Random::instance();
-	// Set stairs position as last room created with a chance
-	if (Random::instance().getBool(0.3F) && !isEasyLayout) {
-		engine.stairs->x = Random::instance().getInt(x1, x2);
-		engine.stairs->y = Random::instance().getInt(y1, y2);
+	// Rooms are mostly empty, so a few random picks nearly always do
+	for (int tries = 0; tries < 8; tries++) {
+		x = rng.getInt(bounds.x1, bounds.x2);
+		y = rng.getInt(bounds.y1, bounds.y2);
+		if (canWalk(x, y)) return true;
 	}
+	std::vector<std::array<int, 2>> freeTiles;
+	for (int ty = bounds.y1; ty <= bounds.y2; ty++)
+		for (int tx = bounds.x1; tx <= bounds.x2; tx++)
+			if (canWalk(tx, ty)) freeTiles.push_back({tx, ty});
+	if (freeTiles.empty()) return false;
+	auto [freeX, freeY] = freeTiles[rng.getInt(0, (int)freeTiles.size() - 1)];
+	x = freeX;
+	y = freeY;
+	return true;
 }
 
-void Map::addMonsters() {
+// Free tiles of rooms, as x + y * width
+std::vector<int> Map::getFreeRoomTiles() const {
+	std::vector<int> freeTiles;
+	for (const Room& room : rooms)
+		for (int y = room.y1; y <= room.y2; y++)
+			for (int x = room.x1; x <= room.x2; x++)
+				if (engine.freeTiles.contains(x, y)) freeTiles.push_back(x + y * width);
+	return freeTiles;
+}
+
+/*
+	Pick count tiles among candidates, spread out like Poisson-disk samples. Candidates are visited in random order
+	and kept if no tile picked so far, nor any tile of avoid, is closer than a radius. The radius starts at the mean
+	spacing count tiles would have and shrinks after each pass over the candidates left, down to 1 where every tile
+	is kept, so count tiles are always picked if there are that many candidates. Tiles are x + y * width.
+*/
+std::vector<int> Map::spreadTiles(std::vector<int> candidates, int count, const std::vector<int>& avoid) const {
 	Random& rng = Random::instance();
-	std::vector<std::pair<int, int>> positions = {};
-	for (auto [x1, y1, x2, y2] : roomRecords) {
-		for (int x = x1; x <= x2; x++)
-			for (int y = y1; y <= y2; y++) {
-				if (engine.getActor(x, y) == NULL) {
-					positions.push_back({x, y});
-				}
+	for (int i = (int)candidates.size() - 1; i > 0; i--) std::swap(candidates[i], candidates[rng.getInt(0, i)]);
+	count = std::min(count, (int)candidates.size());
+	std::vector<int> picked, points(avoid), left;
+	if (count <= 0) return picked;
+
+	// Points bucketed by cells of radius tiles, so only the 3x3 cells around a tile can hold one too close. Buckets
+	// are lists of indices into points linked through next, as most cells of a large map stay empty.
+	std::vector<int> grid, next;
+	int radius = std::max(1, (int)std::sqrt((double)candidates.size() / count));
+	while (true) {
+		int gridWidth = width / radius + 1, gridHeight = height / radius + 1;
+		grid.assign(gridWidth * gridHeight, -1);
+		next.clear();
+		auto add = [&](int point) {
+			int& head = grid[points[point] % width / radius + points[point] / width / radius * gridWidth];
+			next.push_back(head);
+			head = point;
+		};
+		for (int point = 0; point < (int)points.size(); point++) add(point);
+		left.clear();
+		for (int tile : candidates) {
+			int x = tile % width, y = tile / width;
+			int cx = x / radius, cy = y / radius;
+			bool isTooClose = false;
+			for (int ny = std::max(0, cy - 1); ny <= std::min(gridHeight - 1, cy + 1) && !isTooClose; ny++)
+				for (int nx = std::max(0, cx - 1); nx <= std::min(gridWidth - 1, cx + 1) && !isTooClose; nx++)
+					for (int i = grid[nx + ny * gridWidth]; i >= 0; i = next[i]) {
+						int dx = points[i] % width - x, dy = points[i] / width - y;
+						if (dx * dx + dy * dy < radius * radius) {
+							isTooClose = true;
+							break;
+						}
+					}
+			if (isTooClose || (int)picked.size() == count) {
+				left.push_back(tile);
+			} else {
+				picked.push_back(tile);
+				points.push_back(tile);
+				add((int)points.size() - 1);
 			}
-	}
-	int nbMonsters = 10;
-	if (ENEMY_DENSITY_BY_FLOOR[engine.level - 1] == 2)
-		nbMonsters = 20;
-	else if (ENEMY_DENSITY_BY_FLOOR[engine.level - 1] == 3)
-		nbMonsters = 30;
-	while (nbMonsters--) {
-		auto [x, y] = positions[Random::instance().getInt(0, (int)(positions.size()) - 1)];
-		if (engine.getActor(x, y) == NULL) {
-			Actor* enemy = Enemy::newEnemy(x, y);
-			Enemy::setRandomEnemyByFloor(enemy);
 		}
+		if ((int)picked.size() == count || radius == 1) break;
+		candidates.swap(left);
+		radius = std::max(1, std::min(radius - 1, radius * 3 / 4));
+	}
+	return picked;
+}
+
+// Monsters spread over the rooms, keeping their distance from the player
+void Map::addMonsters() {
+	int nbMonsters = scaleToArea(Content::get().getFloor(engine.level).nbMonsters, *this);
+	std::vector<int> avoid = {engine.player->x + engine.player->y * width};
+	for (int tile : spreadTiles(getFreeRoomTiles(), nbMonsters, avoid)) {
+		Actor* enemy = Enemy::newEnemy(tile % width, tile / width);
+		Enemy::setRandomEnemyByFloor(enemy);
 	}
 }
 
 #include <iostream>
 // Add a monster
 void Map::addOneNewMonster() {
-	Random& rng = Random::instance();
-	int tries = 10;
 	int x, y;
-	do {
-		tries--;
-		int roomIndex = rng.getInt(0, (int)(roomRecords.size()) - 1);
-		auto [x1, y1, x2, y2] = roomRecords[roomIndex];
-		x = rng.getInt(x1, x2);
-		y = rng.getInt(y1, y2);
-	} while ((engine.getActor(x, y) != NULL || engine.player->getDistance(x, y) <= 12.0F) && (tries > 0));
-
-	if (engine.getActor(x, y) == NULL && engine.player->getDistance(x, y) > 12.0F) {
+	// Near enough to matter, but away from the player so monsters do not appear in plain sight
+	int playerX = engine.player->x, playerY = engine.player->y;
+	bool found = engine.freeTiles.sampleNear(playerX, playerY, Engine::ACTIVE_RANGE, x, y, [&](int tx, int ty) {
+		return (tx - playerX) * (tx - playerX) + (ty - playerY) * (ty - playerY) > 12 * 12;
+	});
+	if (found) {
 		Actor* enemy = Enemy::newEnemy(x, y);
 		Enemy::setRandomEnemyByFloor(enemy);
 	}
 }
 
+// Items spread over the rooms
 void Map::addItems() {
 	Random& rng = Random::instance();
-	int nbItems = rng.getInt(MIN_TOTAL_ITEMS_BY_FLOOR[engine.level - 1], MAX_TOTAL_ITEMS_BY_FLOOR[engine.level - 1]);
-	int nbIDScrolls = rng.getInt(0, MAX_ID_SCROLL_BY_FLOOR[engine.level - 1]);
-	for (int i = 0; i < nbItems + nbIDScrolls; i++) {
-		int roomIndex = rng.getInt(0, (int)(roomRecords.size()) - 1);
-		int x, y;
-		auto [x1, y1, x2, y2] = roomRecords[roomIndex];
-		x = rng.getInt(x1, x2);
-		y = rng.getInt(y1, y2);
-		if (engine.getActor(x, y) == NULL) {
-			Actor* item = Item::newItem(x, y);
-			if (i < nbIDScrolls)
-				Item::setScrollOfIdentify(item);
-			else
-				Item::setRandomItem(item);
-		}
+	const Content::Floor& floor = Content::get().getFloor(engine.level);
+	int nbItems = scaleToArea(rng.getInt(floor.minItems, floor.maxItems), *this);
+	int nbIDScrolls = scaleToArea(rng.getInt(0, floor.maxIdScrolls), *this);
+	std::vector<int> tiles = spreadTiles(getFreeRoomTiles(), nbItems + nbIDScrolls, {});
+	for (int i = 0; i < (int)tiles.size(); i++) {
+		Actor* item = Item::newItem(tiles[i] % width, tiles[i] / width);
+		if (i < nbIDScrolls)
+			Item::setItem(item, Item::SCROLL_OF_IDENTIFY);
+		else
+			Item::setRandomItem(item);
 	}
 }
 
 std::array<int, 2> Map::directionAtTarget(int x, int y, int cx, int cy) {
-	const int INF = 10000;
-	std::vector<std::vector<int>> dist(width, std::vector<int>(height, INF));
-
-	std::priority_queue<
-		std::pair<int, std::pair<int, int>>,
-		std::vector<std::pair<int, std::pair<int, int>>>,
-		std::greater<>>
-		pq;
-
-	dist[x][y] = 0;
-	pq.push({0, {x, y}});
+	const int INF = 1 << 30;
+	if (x < 0 || x >= width || y < 0 || y >= height || cx < 0 || cx >= width || cy < 0 || cy >= height) return {0, 0};
+	engine.perfOverlay.counters.pathSearches++;
+	// Search the square within ACTIVE_RANGE of the seeker only, so a search costs the same on any size of map
+	int range = Engine::ACTIVE_RANGE;
+	int x1 = std::max(0, cx - range), x2 = std::min(width - 1, cx + range);
+	int y1 = std::max(0, cy - range), y2 = std::min(height - 1, cy + range);
+	int w = x2 - x1 + 1, h = y2 - y1 + 1;
+	// Flat buffers reused between searches, and blocking actors looked up once per search rather than per tile
+	pathDist.assign(w * h, INF);
+	pathBlocked.assign(w * h, 0);
+	engine.spatialIndex.forEachInRect(x1, y1, x2, y2, [&](Actor* actor) {
+		if (actor->blocks) pathBlocked[actor->x - x1 + (actor->y - y1) * w] = 1;
+	});
+	auto canWalkFast = [&](int tx, int ty) { return !pathBlocked[tx - x1 + (ty - y1) * w] && isWalkable(tx, ty); };
+
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> pq;
+
+	if (x >= x1 && x <= x2 && y >= y1 && y <= y2) {
+		pathDist[x - x1 + (y - y1) * w] = 0;
+		pq.push({0, x - x1 + (y - y1) * w});
+	} else {
+		// Target out of the square, start from its free edge tiles at their straight line cost to the target
+		for (int ty = y1; ty <= y2; ty++) {
+			int step = ty == y1 || ty == y2 || w == 1 ? 1 : w - 1;
+			for (int tx = x1; tx <= x2; tx += step) {
+				if (!canWalkFast(tx, ty)) continue;
+				int dx = std::abs(x - tx), dy = std::abs(y - ty);
+				int cost = 10 * std::max(dx, dy) + std::min(dx, dy);
+				pathDist[tx - x1 + (ty - y1) * w] = cost;
+				pq.push({cost, tx - x1 + (ty - y1) * w});
+			}
+		}
+	}
 
 	const int dx[9] = {-1, -1, -1, 0, 0, 1, 1, 1, 0};
 	const int dy[9] = {-1, 0, 1, -1, 1, -1, 0, 1, 0};
+	const int seekerIndex = cx - x1 + (cy - y1) * w;
 
 	while (!pq.empty()) {
-		auto [d, pos] = pq.top();
+		auto [d, index] = pq.top();
 		pq.pop();
-		int x = pos.first;
-		int y = pos.second;
+		int x = x1 + index % w;
+		int y = y1 + index / w;
 
-		if (d > dist[x][y]) continue;  // Already found a better path
+		if (d > pathDist[index]) continue;  // Already found a better path
+		engine.perfOverlay.counters.nodesExpanded++;
+		// Every neighbour of the seeker is settled once we are a diagonal step past it
+		if (pathDist[seekerIndex] != INF && d > pathDist[seekerIndex] + 11) break;
 
 		for (int dir = 0; dir < 8; dir++) {
 			int nx = x + dx[dir];
 			int ny = y + dy[dir];
 
-			if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
-			if ((nx != cx || ny != cy) && !canWalk(nx, ny)) continue;
+			if (nx < x1 || ny < y1 || nx > x2 || ny > y2) continue;
+			if ((nx != cx || ny != cy) && !canWalkFast(nx, ny)) continue;
 
 			int nd = d + 10;  // Cost to move is 10
 			if (dx[dir] != 0 && dy[dir] != 0) nd = d + 11;
-			if (dist[nx][ny] == INF || nd < dist[nx][ny]) {
-				dist[nx][ny] = nd;
-				pq.push({nd, {nx, ny}});
+			int next = nx - x1 + (ny - y1) * w;
+			if (pathDist[next] == INF || nd < pathDist[next]) {
+				pathDist[next] = nd;
+				pq.push({nd, next});
 			}
 		}
 	}
@@ -287,10 +549,11 @@ std::array<int, 2> Map::directionAtTarget(int x, int y, int cx, int cy) {
 	int bestDist = INF;
 	for (int dir = 0; dir < 9; dir++) {
 		int nx = cx + dx[dir], ny = cy + dy[dir];
-		if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
-		if ((nx != cx || ny != cy) && !canWalk(nx, ny) && dist[nx][ny] > 0) continue;
-		if (dist[nx][ny] < bestDist) {
-			bestDist = dist[nx][ny];
+		if (nx < x1 || ny < y1 || nx > x2 || ny > y2) continue;
+		int next = nx - x1 + (ny - y1) * w;
+		if ((nx != cx || ny != cy) && !canWalkFast(nx, ny) && pathDist[next] > 0) continue;
+		if (pathDist[next] < bestDist) {
+			bestDist = pathDist[next];
 			answerdx = dx[dir];
 			answerdy = dy[dir];
 		}
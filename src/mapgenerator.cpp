@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <numeric>
+#include <vector>
+
+#include "main.hpp"
+
+static const int ROOM_MAX_SIZE = 12;
+static const int ROOM_MIN_SIZE = 4;
+// Room ids must stay below Map::CORRIDOR, and a tree this deep has up to 2^15 rooms
+static const int MAX_BSP_DEPTH = 15;
+static const int MAX_ROOMS = 1 << MAX_BSP_DEPTH;
+
+static const int NB_CAVE_STEPS = 4;
+// Fraction of the floor a drunkard walk opens, and steps of a walk before it starts over
+static const double WALK_OPEN_FRACTION = 0.4;
+static const int WALK_LENGTH = 200;
+// Tiles of floor per room placement tried, and odds against opening another door between regions already joined
+static const int MAZE_TILES_PER_ROOM_TRY = 50;
+static const int MAZE_EXTRA_DOOR_ODDS = 25;
+
+static constexpr const char* KIND_NAMES[MapGenerator::NB_KINDS] = {"bsp", "caves", "walk", "maze"};
+
+// Orthogonal steps, the only ones walks and mazes dig along so they never join through a corner only
+static constexpr int DIRECTIONS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+MapGenerator* MapGenerator::create(Kind kind) {
+	switch (kind) {
+		case CAVES:
+			return new CaveGenerator();
+		case DRUNKARD_WALK:
+			return new DrunkardWalkGenerator();
+		case ROOMS_AND_MAZE:
+			return new RoomMazeGenerator();
+		default:
+			return new BspGenerator();
+	}
+}
+
+const char* MapGenerator::getName(Kind kind) { return KIND_NAMES[kind]; }
+
+MapGenerator::Kind MapGenerator::getKindByName(std::string_view name) {
+	for (int kind = 0; kind < NB_KINDS; kind++)
+		if (name == KIND_NAMES[kind]) return (Kind)kind;
+	return NB_KINDS;
+}
+
+void MapGenerator::addAreas(Map& map) {
+	// Larger on big floors, so there are no more areas than a BSP tree has rooms
+	int side = ROOM_MAX_SIZE;
+	while ((long long)(map.width / side + 1) * (map.height / side + 1) > MAX_ROOMS) side++;
+	for (int y1 = 0; y1 < map.height; y1 += side)
+		for (int x1 = 0; x1 < map.width; x1 += side) {
+			int x2 = std::min(x1 + side, map.width) - 1, y2 = std::min(y1 + side, map.height) - 1;
+			bool hasFloor = false;
+			for (int y = y1; y <= y2 && !hasFloor; y++)
+				for (int x = x1; x <= x2 && !hasFloor; x++) hasFloor = map.isWalkable(x, y);
+			if (hasFloor) map.rooms.push_back({x1, y1, x2, y2, 0, {}});
+		}
+}
+
+// Bsp Listener class for randomly creating rooms in the Bsp tree algorithm
+class BspListener : public ITCODBspCallback {
+   private:
+	Map& map;  // a map to dig
+	int roomNum;  // room number
+	int lastx, lasty;  // center of the last room
+   public:
+	BspListener(Map& map) : map(map), roomNum(0) {}
+	bool visitNode(TCODBsp* node, void* userData) {
+		if (node->isLeaf()) {
+			int x, y, w, h;
+			// dig a room
+			Random& rng = Random::instance();
+			w = rng.getInt(ROOM_MIN_SIZE, node->w - 2);
+			h = rng.getInt(ROOM_MIN_SIZE, node->h - 2);
+			x = rng.getInt(node->x + 1, node->x + node->w - w - 1);
+			y = rng.getInt(node->y + 1, node->y + node->h - h - 1);
+			map.createRoom(roomNum == 0, x, y, x + w - 1, y + h - 1);
+			if (roomNum != 0) {
+				// dig a corridor from last room
+				map.dig(lastx, lasty, x + w / 2, lasty);
+				map.dig(x + w / 2, lasty, x + w / 2, y + h / 2);
+				map.corridorRecords.push_back({lastx, lasty, x + w / 2, y + h / 2});
+			}
+			lastx = x + w / 2;
+			lasty = y + h / 2;
+			roomNum++;
+		}
+		return true;
+	}
+};
+
+// Default size floors are split 8 times, larger ones once more each time their area doubles so rooms keep their size
+static int bspDepth(int width, int height) {
+	int depth = 8;
+	for (long long area = (long long)Engine::MAP_WIDTH * Engine::MAP_HEIGHT;
+		 area < (long long)width * height && depth < MAX_BSP_DEPTH;
+		 area *= 2)
+		depth++;
+	return depth;
+}
+
+void BspGenerator::generate(Map& map) {
+	// Split with a generator seeded from ours, so a floor is fully determined by the Random seed
+	TCODRandom bspRng(Random::instance().rng(), TCOD_RNG_CMWC);
+	TCODBsp bsp(0, 0, map.width, map.height);
+	bsp.splitRecursive(&bspRng, bspDepth(map.width, map.height), ROOM_MAX_SIZE, ROOM_MAX_SIZE, 1.5f, 1.5f);
+	BspListener listener(map);
+	bsp.traverseInvertedLevelOrder(&listener, NULL);
+}
+
+static void fullAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry) {
+	uint64_t ab = a ^ b;
+	sum = ab ^ c;
+	carry = (a & b) | (ab & c);
+}
+
+void CaveGenerator::step(const BitBoard& walls, BitBoard& next) {
+	assert(walls.isSameRect(next));
+	int width = walls.getWidth(), height = walls.getHeight(), nbWords = walls.getNbWords();
+	// Bits past the width are off the board too
+	uint64_t padding = width % 64 ? ~((uint64_t(1) << (width % 64)) - 1) : 0;
+	auto word = [&](int row, int w) {
+		if (row < 0 || row >= height || w < 0 || w >= nbWords) return ~uint64_t(0);
+		uint64_t bits = walls.rowWords(row)[w];
+		return w == nbWords - 1 ? bits | padding : bits;
+	};
+	for (int row = 0; row < height; row++) {
+		uint64_t* out = next.rowWords(row);
+		for (int w = 0; w < nbWords; w++) {
+			// Walls among the 3 tiles of each row of the blocks, as a sum bit and a carry bit
+			uint64_t sums[3], carries[3];
+			for (int i = 0; i < 3; i++) {
+				uint64_t center = word(row + i - 1, w);
+				uint64_t west = (center << 1) | (word(row + i - 1, w - 1) >> 63);
+				uint64_t east = (center >> 1) | (word(row + i - 1, w + 1) << 63);
+				fullAdd(west, center, east, sums[i], carries[i]);
+			}
+			// The 9 are ones + 2 * (twos + 2 * (fours + 2 * eights))
+			uint64_t ones, twos, fours, eights, partialTwos, carryTwos, carryFours;
+			fullAdd(sums[0], sums[1], sums[2], ones, carryTwos);
+			fullAdd(carries[0], carries[1], carries[2], partialTwos, carryFours);
+			twos = partialTwos ^ carryTwos;
+			uint64_t moreFours = partialTwos & carryTwos;
+			fours = carryFours ^ moreFours;
+			eights = carryFours & moreFours;
+			out[w] = eights | (fours & (twos | ones));
+		}
+		next.clipRow(row);
+	}
+}
+
+void CaveGenerator::generate(Map& map) {
+	Random& rng = Random::instance();
+	int width = map.width, height = map.height;
+	auto randomWord = [&]() { return (uint64_t)(uint32_t)rng.rng() << 32 | (uint32_t)rng.rng(); };
+	// Tiles start as walls with a chance of 15/32, a random bit and'ed with the or of four others
+	BitBoard walls(0, 0, width, height), next(0, 0, width, height);
+	for (int row = 0; row < height; row++) {
+		uint64_t* words = walls.rowWords(row);
+		for (int w = 0; w < walls.getNbWords(); w++)
+			words[w] = randomWord() & (randomWord() | randomWord() | randomWord() | randomWord());
+		walls.clipRow(row);
+	}
+	for (int i = 0; i < NB_CAVE_STEPS; i++) {
+		step(walls, next);
+		std::swap(walls, next);
+	}
+	// Edges of the map stay rock
+	BitBoard floor(0, 0, width, height);
+	for (int y = 1; y < height - 1; y++) floor.setRow(y, 1, width - 2);
+	floor.subtract(walls);
+	floor.forEach([&](int x, int y) { map.dig(x, y, x, y); });
+
+	// The player starts in the largest cave, the others are filled in by Map::connectAndPlaceStairs()
+	std::vector<int> cave((size_t)width * height, -1), queue, largest;
+	floor.forEach([&](int x, int y) {
+		int start = x + y * width;
+		if (cave[start] != -1) return;
+		queue.clear();
+		queue.push_back(start);
+		cave[start] = start;
+		for (size_t head = 0; head < queue.size(); head++) {
+			int cx = queue[head] % width, cy = queue[head] / width;
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++) {
+					int nx = cx + dx, ny = cy + dy;
+					if (!floor.get(nx, ny) || cave[nx + ny * width] != -1) continue;
+					cave[nx + ny * width] = start;
+					queue.push_back(nx + ny * width);
+				}
+		}
+		if (queue.size() > largest.size()) largest.swap(queue);
+	});
+	if (largest.empty()) {
+		// Nothing but rock is left, open a tile for the player
+		map.dig(width / 2, height / 2, width / 2, height / 2);
+		largest.push_back(width / 2 + height / 2 * width);
+	}
+	int start = largest[rng.getInt(0, (int)largest.size() - 1)];
+	engine.player->moveTo(start % width, start / width);
+	addAreas(map);
+}
+
+void DrunkardWalkGenerator::generate(Map& map) {
+	Random& rng = Random::instance();
+	int width = map.width, height = map.height;
+	long long target = (long long)((width - 2) * (height - 2) * WALK_OPEN_FRACTION);
+	BitBoard open(0, 0, width, height);
+	std::vector<int> dug;
+	auto dig = [&](int x, int y) {
+		if (open.get(x, y)) return;
+		open.set(x, y);
+		dug.push_back(x + y * width);
+		map.dig(x, y, x, y);
+	};
+	int x = width / 2, y = height / 2;
+	dig(x, y);
+	engine.player->moveTo(x, y);
+	while ((long long)dug.size() < target) {
+		for (int i = 0; i < WALK_LENGTH && (long long)dug.size() < target; i++) {
+			auto [dx, dy] = DIRECTIONS[rng.getInt(0, 3)];
+			// Edges of the map stay rock
+			x = std::clamp(x + dx, 1, width - 2);
+			y = std::clamp(y + dy, 1, height - 2);
+			dig(x, y);
+		}
+		int from = dug[rng.getInt(0, (int)dug.size() - 1)];
+		x = from % width;
+		y = from / width;
+	}
+	addAreas(map);
+}
+
+void RoomMazeGenerator::generate(Map& map) {
+	Random& rng = Random::instance();
+	int width = map.width, height = map.height;
+	// Region of every tile, -1 for rock, rooms first then one per maze. Rooms and maze cells are on odd coordinates,
+	// so the walls between them are one tile thick.
+	std::vector<int> region((size_t)width * height, -1);
+	auto isRock = [&](int x, int y) { return region[x + y * width] < 0; };
+	int lastX = (width - 2) % 2 ? width - 2 : width - 3;
+	int lastY = (height - 2) % 2 ? height - 2 : height - 3;
+
+	std::vector<std::array<int, 4>> rooms;
+	int tries = std::max(1, width * height / MAZE_TILES_PER_ROOM_TRY);
+	for (int i = 0; i < tries && (int)rooms.size() < MAX_ROOMS; i++) {
+		int w = rng.getInt(ROOM_MIN_SIZE / 2, ROOM_MAX_SIZE / 2 - 1) * 2 + 1;
+		int h = rng.getInt(ROOM_MIN_SIZE / 2, ROOM_MAX_SIZE / 2 - 1) * 2 + 1;
+		if (w > lastX || h > lastY) continue;
+		int x1 = rng.getInt(0, (lastX - w) / 2) * 2 + 1, y1 = rng.getInt(0, (lastY - h) / 2) * 2 + 1;
+		int x2 = x1 + w - 1, y2 = y1 + h - 1;
+		bool isFree = true;
+		for (int y = y1 - 1; y <= y2 + 1 && isFree; y++)
+			for (int x = x1 - 1; x <= x2 + 1 && isFree; x++) isFree = isRock(x, y);
+		if (!isFree) continue;
+		for (int y = y1; y <= y2; y++)
+			for (int x = x1; x <= x2; x++) region[x + y * width] = (int)rooms.size();
+		rooms.push_back({x1, y1, x2, y2});
+	}
+	int nbRooms = (int)rooms.size(), nbRegions = nbRooms;
+
+	// Every cell left is reached by a randomized depth first search, one maze per group of cells the rooms cut off
+	std::vector<int> stack;
+	for (int cy = 1; cy <= lastY; cy += 2)
+		for (int cx = 1; cx <= lastX; cx += 2) {
+			if (!isRock(cx, cy)) continue;
+			region[cx + cy * width] = nbRegions;
+			stack.assign(1, cx + cy * width);
+			while (!stack.empty()) {
+				int x = stack.back() % width, y = stack.back() / width;
+				int options[4], nbOptions = 0;
+				for (int d = 0; d < 4; d++) {
+					int nx = x + 2 * DIRECTIONS[d][0], ny = y + 2 * DIRECTIONS[d][1];
+					if (nx >= 1 && nx <= lastX && ny >= 1 && ny <= lastY && isRock(nx, ny)) options[nbOptions++] = d;
+				}
+				if (nbOptions == 0) {
+					stack.pop_back();
+					continue;
+				}
+				auto [dx, dy] = DIRECTIONS[options[rng.getInt(0, nbOptions - 1)]];
+				region[x + dx + (y + dy) * width] = nbRegions;
+				region[x + 2 * dx + (y + 2 * dy) * width] = nbRegions;
+				stack.push_back(x + 2 * dx + (y + 2 * dy) * width);
+			}
+			nbRegions++;
+		}
+
+	// Rock between two regions is a door candidate. Doors are opened in random order wherever they join regions not
+	// yet connected, plus a few more for loops.
+	std::vector<std::array<int, 3>> doors;
+	for (int y = 1; y < height - 1; y++)
+		for (int x = 1; x < width - 1; x++) {
+			if (!isRock(x, y)) continue;
+			int west = region[x - 1 + y * width], east = region[x + 1 + y * width];
+			int north = region[x + (y - 1) * width], south = region[x + (y + 1) * width];
+			if (west >= 0 && east >= 0 && west != east)
+				doors.push_back({x + y * width, west, east});
+			else if (north >= 0 && south >= 0 && north != south)
+				doors.push_back({x + y * width, north, south});
+		}
+	for (int i = (int)doors.size() - 1; i > 0; i--) std::swap(doors[i], doors[rng.getInt(0, i)]);
+	std::vector<int> parent(nbRegions);
+	std::iota(parent.begin(), parent.end(), 0);
+	auto find = [&](int id) {
+		while (parent[id] != id) id = parent[id] = parent[parent[id]];
+		return id;
+	};
+	// Doors get a region of their own so they are not taken for room tiles
+	int doorRegion = nbRegions;
+	for (auto [tile, a, b] : doors) {
+		int rootA = find(a), rootB = find(b);
+		if (rootA != rootB)
+			parent[rootA] = rootB;
+		else if (rng.getInt(0, MAZE_EXTRA_DOOR_ODDS - 1) != 0)
+			continue;
+		region[tile] = doorRegion;
+	}
+
+	// Fill in dead ends until every corridor leads somewhere
+	auto isCorridor = [&](int tile) { return region[tile] >= nbRooms; };
+	std::vector<int> work;
+	for (int tile = 0; tile < width * height; tile++)
+		if (isCorridor(tile)) work.push_back(tile);
+	while (!work.empty()) {
+		int tile = work.back();
+		work.pop_back();
+		if (!isCorridor(tile)) continue;
+		int x = tile % width, y = tile / width, nbOpen = 0;
+		for (auto [dx, dy] : DIRECTIONS) nbOpen += !isRock(x + dx, y + dy);
+		if (nbOpen > 1) continue;
+		region[tile] = -1;
+		for (auto [dx, dy] : DIRECTIONS)
+			if (isCorridor(tile + dx + dy * width)) work.push_back(tile + dx + dy * width);
+	}
+
+	for (int i = 0; i < nbRooms; i++) map.createRoom(i == 0, rooms[i][0], rooms[i][1], rooms[i][2], rooms[i][3]);
+	for (int tile = 0; tile < width * height; tile++)
+		if (isCorridor(tile)) map.dig(tile % width, tile / width, tile % width, tile / width);
+	if (nbRooms == 0) {
+		// Too small for a room, the whole maze filled back in
+		map.dig(width / 2, height / 2, width / 2, height / 2);
+		engine.player->moveTo(width / 2, height / 2);
+	}
+}
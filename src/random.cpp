@@ -3,9 +3,9 @@
 #include <cassert>
 #include <chrono>
 
-// Singleton instance access
+// Singleton instance access, one generator per thread
 Random& Random::instance() {
-	static Random random = Random();
+	thread_local Random random = Random();
 	return random;
 }
 
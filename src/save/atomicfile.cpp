@@ -0,0 +1,35 @@
+#include "save/atomicfile.hpp"
+
+#include <cstdio>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Make sure the content of file reached the disk
+static bool syncFile(FILE* file) {
+	if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool AtomicFile::write(const std::filesystem::path& path, const uint8_t* data, size_t size) {
+	auto tempPath = path;
+	tempPath += ".tmp";
+	FILE* file = std::fopen(tempPath.string().c_str(), "wb");
+	if (!file) return false;
+	bool isWritten = std::fwrite(data, 1, size, file) == size && syncFile(file);
+	std::error_code error;
+	if (std::fclose(file) != 0 || !isWritten) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	std::filesystem::rename(tempPath, path, error);
+	return !error;
+}
@@ -0,0 +1,92 @@
+#include "save/autosaver.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "main.hpp"
+
+AutoSaver::AutoSaver(const std::filesystem::path& path) : path(path) {
+#ifndef __EMSCRIPTEN__
+	worker = std::thread(&AutoSaver::run, this);
+#endif
+}
+
+AutoSaver::~AutoSaver() {
+#ifndef __EMSCRIPTEN__
+	{
+		std::lock_guard lock(mutex);
+		isStopping = true;
+	}
+	wakeUp.notify_one();
+	worker.join();
+#endif
+}
+
+void AutoSaver::snapshot() {
+	auto start = std::chrono::steady_clock::now();
+	int index;
+	{
+		std::lock_guard lock(mutex);
+		// Fill the buffer the worker is not writing, dropping the snapshot in it if the worker did not pick it up yet
+		index = writing == 0 ? 1 : 0;
+		if (pending == index) pending = -1;
+	}
+	SaveGame::write(buffers[index]);
+	double snapshotUs = elapsedUs(start);
+	{
+		std::lock_guard lock(mutex);
+		stats.snapshots++;
+		stats.snapshotUsTotal += snapshotUs;
+		stats.snapshotUsMax = std::max(stats.snapshotUsMax, snapshotUs);
+#ifndef __EMSCRIPTEN__
+		pending = index;
+#endif
+	}
+#ifdef __EMSCRIPTEN__
+	// No threads in the browser build, write on the spot
+	writeSnapshot(index);
+#else
+	wakeUp.notify_one();
+#endif
+}
+
+void AutoSaver::flush() {
+	std::unique_lock lock(mutex);
+	idle.wait(lock, [this] { return pending == -1 && writing == -1; });
+}
+
+AutoSaver::Stats AutoSaver::getStats() {
+	std::lock_guard lock(mutex);
+	return stats;
+}
+
+// Worker loop, writes pending snapshots until stopped
+void AutoSaver::run() {
+	std::unique_lock lock(mutex);
+	while (true) {
+		wakeUp.wait(lock, [this] { return pending != -1 || isStopping; });
+		if (pending == -1) return;
+		int index = writing = pending;
+		pending = -1;
+		lock.unlock();
+		writeSnapshot(index);
+		lock.lock();
+		writing = -1;
+		idle.notify_all();
+	}
+}
+
+// Compress and write buffers[index], called without holding the mutex
+void AutoSaver::writeSnapshot(int index) {
+	auto start = std::chrono::steady_clock::now();
+	bool isWritten = SaveGame::compress(buffers[index], compressed) &&
+					 AtomicFile::write(path, compressed.data(), compressed.size());
+	double writeUs = elapsedUs(start);
+	std::lock_guard lock(mutex);
+	stats.writes++;
+	if (!isWritten) stats.failedWrites++;
+	stats.writeUsTotal += writeUs;
+	stats.writeUsMax = std::max(stats.writeUsMax, writeUs);
+	stats.lastSaveBytes = buffers[index].size();
+	stats.lastCompressedBytes = compressed.size();
+}
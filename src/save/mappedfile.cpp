@@ -0,0 +1,58 @@
+#include "save/mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+	: contents(NULL), length(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL) {
+	fileHandle =
+		CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) return;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) return;
+	mappingHandle = CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL) return;
+	void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) return;
+	contents = static_cast<const uint8_t*>(view);
+	length = (size_t)fileSize.QuadPart;
+}
+
+MappedFile::~MappedFile() {
+	if (contents) UnmapViewOfFile(contents);
+	if (mappingHandle) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) : contents(NULL), length(0) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return;
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view != MAP_FAILED) {
+			contents = static_cast<const uint8_t*>(view);
+			length = (size_t)info.st_size;
+		}
+	}
+	// The mapping keeps its own reference to the file
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (contents) munmap(const_cast<uint8_t*>(contents), length);
+}
+
+#endif
@@ -0,0 +1,747 @@
+#include "save/savegame.hpp"
+
+#include <zlib.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "save/atomicfile.hpp"
+#include "save/mappedfile.hpp"
+
+static constexpr char MAGIC[8] = {'U', 'W', 'S', 'A', 'V', 'E', '\0', '\0'};
+static constexpr uint32_t ENDIAN_TAG = 0x01020304;
+static constexpr size_t SECTION_ALIGNMENT = 8;
+
+enum NameFlags : uint8_t { HAS_IDENTIFY_STATUS = 1, IDENTIFIED = 2, HAS_CALL_NAME = 4 };
+
+// Strings read from saves are interned, so actors can keep pointing at them as they do at literals
+static const char* intern(std::string_view text) {
+	thread_local std::unordered_set<std::string> strings;
+	return strings.emplace(text).first->c_str();
+}
+
+struct SaveGame::Writer {
+	std::vector<Actor*> actors;
+	std::unordered_map<const Actor*, uint32_t> actorIndices;
+
+	std::vector<uint8_t> strings;
+	std::unordered_map<std::string, uint32_t> stringOffsets;
+
+	std::vector<AiRecord> ais;
+
+	uint32_t actorIndex(const Actor* actor) const {
+		auto it = actorIndices.find(actor);
+		return it == actorIndices.end() ? NO_INDEX : it->second;
+	}
+
+	uint32_t addString(const char* text) {
+		if (!text) return NO_INDEX;
+		auto [it, inserted] = stringOffsets.try_emplace(text, (uint32_t)strings.size());
+		if (inserted) strings.insert(strings.end(), text, text + std::strlen(text) + 1);
+		return it->second;
+	}
+
+	// Returns the index of the record written for ai, which comes after the records of the ais it replaced
+	uint32_t addAi(Ai* ai, uint32_t actor) {
+		// An ai of a kind the save does not know is written as NB_AI_KINDS, which loading rejects
+		AiRecord record = {actor, NB_AI_KINDS, NO_INDEX, NO_INDEX, {}};
+		if (dynamic_cast<PlayerAi*>(ai)) {
+			record.kind = PLAYER_AI;
+		} else if (auto temporaryAi = dynamic_cast<TemporaryAi*>(ai)) {
+			if (dynamic_cast<ConfusedPlayerAi*>(ai))
+				record.kind = CONFUSED_PLAYER_AI;
+			else if (dynamic_cast<ConfusedMonsterAi*>(ai))
+				record.kind = CONFUSED_MONSTER_AI;
+			record.oldAi = temporaryAi->oldAi ? addAi(temporaryAi->oldAi, NO_INDEX) : NO_INDEX;
+			record.values[0] = temporaryAi->nbTurns;
+		} else if (auto monsterAi = dynamic_cast<MonsterAi*>(ai)) {
+			record.kind = dynamic_cast<GremlinAi*>(ai) ? GREMLIN_AI
+						  : dynamic_cast<ElfAi*>(ai)   ? ELF_AI
+						  : dynamic_cast<LichAi*>(ai)  ? LICH_AI
+						  : dynamic_cast<DragonAi*>(ai) ? DRAGON_AI
+													   : MONSTER_AI;
+			record.values[0] = monsterAi->wanderingTurn;
+			record.values[1] = monsterAi->chasingTurn;
+			record.values[2] = monsterAi->targetX;
+			record.values[3] = monsterAi->targetY;
+			record.values[4] = monsterAi->globalTurn;
+		} else if (auto fireAi = dynamic_cast<FireAi*>(ai)) {
+			record.kind = FIRE_AI;
+			record.target = actorIndex(fireAi->target);
+			record.values[0] = fireAi->nbTurns;
+		} else if (auto natureAi = dynamic_cast<NatureAi*>(ai)) {
+			record.kind = NATURE_AI;
+			record.values[0] = natureAi->nbTurnsSinceCreation;
+			record.values[1] = natureAi->level;
+		} else if (dynamic_cast<BotAi*>(ai)) {
+			record.kind = BOT_AI;
+		}
+		assert(record.kind != NB_AI_KINDS);	// a new Ai subclass needs a kind of its own
+		ais.push_back(record);
+		return (uint32_t)ais.size() - 1;
+	}
+};
+
+void SaveGame::write(std::vector<uint8_t>& out) { write(out, false); }
+
+void SaveGame::write(std::vector<uint8_t>& out, bool isFloor) {
+	Writer writer;
+	const Map& map = *engine.map;
+
+	// World actors in engine order, then the content of every container after them. A floor is kept without the
+	// player and what it carries.
+	std::vector<uint32_t> owners;
+	for (auto actor : engine.actors)
+		if (!isFloor || actor != engine.player) writer.actors.push_back(actor);
+	owners.assign(writer.actors.size(), NO_INDEX);
+	for (size_t i = 0; i < writer.actors.size(); i++) {
+		writer.actorIndices[writer.actors[i]] = (uint32_t)i;
+		if (writer.actors[i]->container)
+			for (auto item : writer.actors[i]->container->inventory) {
+				writer.actors.push_back(item);
+				owners.push_back((uint32_t)i);
+			}
+	}
+
+	EngineRecord engineRecord = {};
+	engineRecord.level = engine.level;
+	engineRecord.monsterSpawnRate = engine.monsterSpawnRate;
+	engineRecord.fovRadius = engine.fovRadius;
+	engineRecord.mapWidth = map.width;
+	engineRecord.mapHeight = map.height;
+	engineRecord.player = writer.actorIndex(engine.player);
+	engineRecord.stairs = writer.actorIndex(engine.stairs);
+	engineRecord.nature = writer.actorIndex(engine.nature);
+	engineRecord.upStairs = writer.actorIndex(engine.upStairs);
+	engineRecord.isMapRevealed = map.isMapRevealed;
+	engineRecord.isEasyLayout = map.isEasyLayout;
+
+	size_t nbTiles = (size_t)map.width * map.height;
+	std::vector<uint8_t> walkable(nbTiles), transparent(nbTiles), explored(nbTiles);
+	for (int y = 0; y < map.height; y++)
+		for (int x = 0; x < map.width; x++) {
+			size_t i = x + (size_t)y * map.width;
+			walkable[i] = map.isWalkable(x, y);
+			transparent[i] = map.isTransparent(x, y);
+			explored[i] = map.isExplored(x, y);
+		}
+
+	std::vector<ActorRecord> actors;
+	std::vector<DestructibleRecord> destructibles;
+	std::vector<AttackerRecord> attackers;
+	std::vector<PickableRecord> pickables;
+	std::vector<ContainerRecord> containers;
+	actors.reserve(writer.actors.size());
+	for (size_t i = 0; i < writer.actors.size(); i++) {
+		const Actor* actor = writer.actors[i];
+		uint32_t index = (uint32_t)i;
+		ActorRecord record = {};
+		record.x = actor->x;
+		record.y = actor->y;
+		record.name = writer.addString(actor->name);
+		record.owner = owners[i];
+		record.ch = (uint8_t)actor->ch;
+		record.r = actor->color.r;
+		record.g = actor->color.g;
+		record.b = actor->color.b;
+		record.blocks = actor->blocks;
+		record.fovOnly = actor->fovOnly;
+		actors.push_back(record);
+
+		if (Destructible* destructible = actor->destructible)
+			destructibles.push_back(
+				{index,
+				 dynamic_cast<PlayerDestructible*>(destructible) != NULL,
+				 destructible->maxHp,
+				 destructible->hp,
+				 destructible->defense,
+				 writer.addString(destructible->corpseName),
+				 writer.addString(destructible->lastDamageSource)});
+		if (actor->attacker) attackers.push_back({index, actor->attacker->power});
+		if (actor->ai) writer.addAi(actor->ai, index);
+		if (actor->pickable) pickables.push_back({index});
+		if (actor->container) containers.push_back({index, actor->container->size});
+	}
+
+	std::vector<std::array<int32_t, 4>> rooms;
+	for (const Room& room : map.rooms) rooms.push_back({room.x1, room.y1, room.x2, room.y2});
+	std::vector<std::array<int32_t, 4>> corridors(map.corridorRecords.begin(), map.corridorRecords.end());
+
+	// One record per item kind. Names, log and other floors belong to the run, so floors leave them empty.
+	const NameTracker& nameTracker = *engine.nameTracker;
+	std::vector<NameRecord> names;
+	for (int kind = 0; kind < Item::NB_KINDS && !isFloor; kind++) {
+		NameRecord record = {
+			writer.addString(Item::getName((Item::Kind)kind)),
+			writer.addString(nameTracker.defaultNames[kind]),
+			NO_INDEX,
+			(uint8_t)Item::getPrototype((Item::Kind)kind).ch,
+			(uint8_t)(HAS_IDENTIFY_STATUS | (nameTracker.isIdentified[kind] ? IDENTIFIED : 0)),
+			{}};
+		if (nameTracker.callNames[kind][0]) {
+			record.flags |= HAS_CALL_NAME;
+			record.callName = writer.addString(nameTracker.callNames[kind]);
+		}
+		names.push_back(record);
+	}
+
+	const Gui& gui = *engine.gui;
+	std::vector<LogRecord> log;
+	for (int i = 0; i < gui.logSize && !isFloor; i++) {
+		// Events are saved as their text, names and formats are not trusted when loading
+		const Gui::Message& message = gui.logLine(i);
+		char buffer[Gui::Message::MAX_LENGTH + 1];
+		uint32_t text = writer.addString(std::string(message.getText(buffer, sizeof(buffer))).c_str());
+		log.push_back({text, message.color.r, message.color.g, message.color.b, 0, message.count});
+	}
+
+	std::vector<FloorRecord> floors;
+	std::vector<uint8_t> floorData;
+	for (size_t level = 0; level < engine.visitedFloors.size() && !isFloor; level++) {
+		const std::vector<uint8_t>& snapshot = engine.visitedFloors[level];
+		if (snapshot.empty()) continue;
+		floors.push_back({(int32_t)level, 0, floorData.size(), snapshot.size()});
+		floorData.insert(floorData.end(), snapshot.begin(), snapshot.end());
+	}
+
+	struct Section {
+		uint32_t count;
+		const void* data;
+		size_t size;
+	};
+	auto section = [](const auto& records) {
+		return Section{(uint32_t)records.size(), records.data(), records.size() * sizeof(records[0])};
+	};
+	Section sections[NB_SECTIONS] = {};
+	sections[ENGINE] = {1, &engineRecord, sizeof(engineRecord)};
+	sections[WALKABLE] = section(walkable);
+	sections[TRANSPARENT] = section(transparent);
+	sections[EXPLORED] = section(explored);
+	sections[ROOMS] = section(rooms);
+	sections[CORRIDORS] = section(corridors);
+	sections[STRINGS] = section(writer.strings);
+	sections[ACTORS] = section(actors);
+	sections[DESTRUCTIBLES] = section(destructibles);
+	sections[ATTACKERS] = section(attackers);
+	sections[AIS] = section(writer.ais);
+	sections[PICKABLES] = section(pickables);
+	sections[CONTAINERS] = section(containers);
+	sections[NAMES] = section(names);
+	sections[LOG] = section(log);
+	sections[FLOORS] = section(floors);
+	sections[FLOOR_DATA] = section(floorData);
+
+	auto align = [](size_t offset) { return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1); };
+	SectionHeader headers[NB_SECTIONS];
+	size_t offset = align(sizeof(FileHeader) + sizeof(headers));
+	for (uint32_t id = 0; id < NB_SECTIONS; id++) {
+		headers[id] = {id, sections[id].count, offset, sections[id].size};
+		offset = align(offset + sections[id].size);
+	}
+
+	FileHeader header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.endianTag = ENDIAN_TAG;
+	header.sectionCount = NB_SECTIONS;
+	header.fileSize = offset;
+	header.flags = isFloor ? FLOOR : 0;
+
+	out.assign(offset, 0);
+	std::memcpy(out.data(), &header, sizeof(header));
+	std::memcpy(out.data() + sizeof(header), headers, sizeof(headers));
+	for (uint32_t id = 0; id < NB_SECTIONS; id++)
+		if (sections[id].size) std::memcpy(out.data() + headers[id].offset, sections[id].data, sections[id].size);
+}
+
+// Builds a complete game next to the running one. Owns everything it created until commit() hands it to the engine.
+struct SaveGame::Reader {
+	const uint8_t* data;
+	size_t size;
+	const SectionHeader* sections[NB_SECTIONS] = {};
+
+	std::vector<Actor*> actors;
+	std::vector<Ai*> ais;
+	std::vector<std::vector<uint8_t>> floors;
+	Map* map = NULL;
+	Gui* gui = NULL;
+	NameTracker* nameTracker = NULL;
+
+	Reader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	~Reader() {
+		// Ais are owned by the ais list until commit(), not by their actors
+		for (auto actor : actors) actor->ai = NULL;
+		for (auto ai : ais) delete ai;
+		for (auto actor : actors) delete actor;
+		delete map;
+		delete gui;
+		delete nameTracker;
+	}
+
+	template <typename Record>
+	std::pair<const Record*, uint32_t> table(SectionId id) const {
+		return {reinterpret_cast<const Record*>(data + sections[id]->offset), sections[id]->count};
+	}
+
+	const char* stringAt(uint32_t offset) const {
+		if (offset == NO_INDEX) return NULL;
+		return intern(reinterpret_cast<const char*>(data + sections[STRINGS]->offset + offset));
+	}
+
+	bool isString(uint32_t offset, bool optional = false) const {
+		return (optional && offset == NO_INDEX) || offset < sections[STRINGS]->size;
+	}
+
+	bool isActor(uint32_t index, bool optional = false) const {
+		return (optional && index == NO_INDEX) || index < actors.size();
+	}
+
+	bool isOnMap(uint32_t index, bool optional = false) const {
+		if (optional && index == NO_INDEX) return true;
+		auto [actorRecords, nbActors] = table<ActorRecord>(ACTORS);
+		return index < nbActors && actorRecords[index].owner == NO_INDEX;
+	}
+
+	bool readHeaders(uint32_t flags);
+	bool readMap(const EngineRecord& engineRecord);
+	bool readActors();
+	bool readAis();
+	bool readNames();
+	bool readLog();
+	bool readFloors(const EngineRecord& engineRecord);
+	void commit(const EngineRecord& engineRecord);
+	void commitFloor(const EngineRecord& engineRecord);
+};
+
+bool SaveGame::Reader::readHeaders(uint32_t flags) {
+	if (size < sizeof(FileHeader) || reinterpret_cast<uintptr_t>(data) % SECTION_ALIGNMENT) return false;
+	const FileHeader& header = *reinterpret_cast<const FileHeader*>(data);
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+		header.endianTag != ENDIAN_TAG || header.fileSize != size || header.flags != flags)
+		return false;
+	static constexpr size_t RECORD_SIZES[NB_SECTIONS] = {
+		sizeof(EngineRecord),
+		1,
+		1,
+		1,
+		sizeof(std::array<int32_t, 4>),
+		sizeof(std::array<int32_t, 4>),
+		1,
+		sizeof(ActorRecord),
+		sizeof(DestructibleRecord),
+		sizeof(AttackerRecord),
+		sizeof(AiRecord),
+		sizeof(PickableRecord),
+		sizeof(ContainerRecord),
+		sizeof(NameRecord),
+		sizeof(LogRecord),
+		sizeof(FloorRecord),
+		1};
+	auto headers = reinterpret_cast<const SectionHeader*>(data + sizeof(FileHeader));
+	if (sizeof(FileHeader) + (size_t)header.sectionCount * sizeof(SectionHeader) > size) return false;
+	// Unknown sections are skipped, so later versions may add some without breaking older readers
+	for (uint32_t i = 0; i < header.sectionCount; i++) {
+		const SectionHeader& section = headers[i];
+		if (section.offset % SECTION_ALIGNMENT || section.offset > size || section.size > size - section.offset)
+			return false;
+		if (section.id >= NB_SECTIONS) continue;
+		if (sections[section.id] || (uint64_t)section.count * RECORD_SIZES[section.id] != section.size) return false;
+		sections[section.id] = &section;
+	}
+	for (auto section : sections)
+		if (!section) return false;
+	// Every string must be terminated inside the blob
+	auto [strings, nbBytes] = table<char>(STRINGS);
+	return sections[ENGINE]->count == 1 && (nbBytes == 0 || strings[nbBytes - 1] == '\0');
+}
+
+bool SaveGame::Reader::readMap(const EngineRecord& engineRecord) {
+	int width = engineRecord.mapWidth, height = engineRecord.mapHeight;
+	if (width <= 0 || height <= 0 || width > Map::MAX_SIZE || height > Map::MAX_SIZE) return false;
+	uint32_t nbTiles = (uint32_t)(width * height);
+	auto [walkable, nbWalkable] = table<uint8_t>(WALKABLE);
+	auto [transparent, nbTransparent] = table<uint8_t>(TRANSPARENT);
+	auto [explored, nbExplored] = table<uint8_t>(EXPLORED);
+	if (nbWalkable != nbTiles || nbTransparent != nbTiles || nbExplored != nbTiles) return false;
+
+	map = new Map(width, height, false);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) {
+			int i = x + y * width;
+			map->setFlags(
+				x,
+				y,
+				(walkable[i] ? Map::TILE_WALKABLE : 0) | (transparent[i] ? Map::TILE_TRANSPARENT : 0) |
+					(explored[i] ? Map::TILE_EXPLORED : 0));
+		}
+	auto [rooms, nbRooms] = table<std::array<int32_t, 4>>(ROOMS);
+	for (uint32_t i = 0; i < nbRooms; i++) {
+		auto [x1, y1, x2, y2] = rooms[i];
+		if (x1 < 0 || x1 > x2 || x2 >= width || y1 < 0 || y1 > y2 || y2 >= height) return false;
+		map->rooms.push_back({x1, y1, x2, y2, 0, {}});
+	}
+	auto [corridors, nbCorridors] = table<std::array<int32_t, 4>>(CORRIDORS);
+	for (uint32_t i = 0; i < nbCorridors; i++) {
+		auto [x1, y1, x2, y2] = corridors[i];
+		if (x1 < 0 || x1 >= width || x2 < 0 || x2 >= width || y1 < 0 || y1 >= height || y2 < 0 || y2 >= height)
+			return false;
+		map->corridorRecords.push_back(corridors[i]);
+	}
+	map->indexRooms();
+	map->isMapRevealed = engineRecord.isMapRevealed;
+	map->isEasyLayout = engineRecord.isEasyLayout;
+	return true;
+}
+
+bool SaveGame::Reader::readActors() {
+	auto [actorRecords, nbActors] = table<ActorRecord>(ACTORS);
+	actors.reserve(nbActors);
+	for (uint32_t i = 0; i < nbActors; i++) {
+		const ActorRecord& record = actorRecords[i];
+		if (!isString(record.name)) return false;
+		// Actors with no place on the map, nature and fires, are kept at (-1, -1)
+		bool isOffMap = record.x == -1 && record.y == -1;
+		if (!isOffMap && (record.x < 0 || record.x >= map->width || record.y < 0 || record.y >= map->height))
+			return false;
+		Actor* actor =
+			new Actor(record.x, record.y, (char)record.ch, stringAt(record.name), {record.r, record.g, record.b});
+		actor->blocks = record.blocks;
+		actor->fovOnly = record.fovOnly;
+		actors.push_back(actor);
+	}
+
+	auto [destructibles, nbDestructibles] = table<DestructibleRecord>(DESTRUCTIBLES);
+	for (uint32_t i = 0; i < nbDestructibles; i++) {
+		const DestructibleRecord& record = destructibles[i];
+		if (!isActor(record.actor) || actors[record.actor]->destructible || !isString(record.corpseName, true) ||
+			!isString(record.lastDamageSource, true))
+			return false;
+		const char* corpseName = stringAt(record.corpseName);
+		Destructible* destructible = NULL;
+		if (record.isPlayer)
+			destructible = new PlayerDestructible(record.maxHp, record.defense, corpseName);
+		else
+			destructible = new MonsterDestructible(record.maxHp, record.defense, corpseName);
+		destructible->hp = record.hp;
+		destructible->lastDamageSource = stringAt(record.lastDamageSource);
+		actors[record.actor]->destructible = destructible;
+	}
+
+	auto [attackers, nbAttackers] = table<AttackerRecord>(ATTACKERS);
+	for (uint32_t i = 0; i < nbAttackers; i++) {
+		if (!isActor(attackers[i].actor) || actors[attackers[i].actor]->attacker) return false;
+		actors[attackers[i].actor]->attacker = new Attacker(attackers[i].power);
+	}
+
+	// Item components are rebuilt by the item kind, the rest of the actor stays as saved
+	auto [pickables, nbPickables] = table<PickableRecord>(PICKABLES);
+	for (uint32_t i = 0; i < nbPickables; i++) {
+		if (!isActor(pickables[i].actor)) return false;
+		Actor* item = actors[pickables[i].actor];
+		if (item->pickable) return false;
+		char ch = item->ch;
+		auto color = item->color;
+		if (!Item::setItemByName(item, item->name)) return false;
+		item->ch = ch;
+		item->color = color;
+	}
+
+	auto [containers, nbContainers] = table<ContainerRecord>(CONTAINERS);
+	for (uint32_t i = 0; i < nbContainers; i++) {
+		if (!isActor(containers[i].actor) || actors[containers[i].actor]->container) return false;
+		actors[containers[i].actor]->container = new Container(containers[i].size);
+	}
+	for (uint32_t i = 0; i < nbActors; i++) {
+		uint32_t owner = actorRecords[i].owner;
+		if (owner == NO_INDEX) continue;
+		if (!isActor(owner) || owner == i || !actors[owner]->container) return false;
+		actors[owner]->container->inventory.push_back(actors[i]);
+	}
+	return true;
+}
+
+bool SaveGame::Reader::readAis() {
+	auto [records, nbAis] = table<AiRecord>(AIS);
+	ais.reserve(nbAis);
+	// Every ai must end up referenced exactly once, by an actor or by the temporary ai that replaced it
+	std::vector<bool> isReferenced(nbAis, false);
+	for (uint32_t i = 0; i < nbAis; i++) {
+		const AiRecord& record = records[i];
+		if (record.kind >= NB_AI_KINDS || !isActor(record.actor, true) || !isActor(record.target, true)) return false;
+		const int32_t* values = record.values;
+		Ai* ai = NULL;
+		MonsterAi* monsterAi = NULL;
+		TemporaryAi* temporaryAi = NULL;
+		switch (record.kind) {
+			case PLAYER_AI:
+				ai = new PlayerAi();
+				break;
+			case MONSTER_AI:
+				ai = monsterAi = new MonsterAi();
+				break;
+			case GREMLIN_AI:
+				ai = monsterAi = new GremlinAi();
+				break;
+			case ELF_AI:
+				ai = monsterAi = new ElfAi();
+				break;
+			case LICH_AI:
+				ai = monsterAi = new LichAi();
+				break;
+			case DRAGON_AI:
+				ai = monsterAi = new DragonAi();
+				break;
+			case CONFUSED_MONSTER_AI:
+				ai = temporaryAi = new ConfusedMonsterAi(values[0]);
+				break;
+			case CONFUSED_PLAYER_AI:
+				ai = temporaryAi = new ConfusedPlayerAi(values[0]);
+				break;
+			case FIRE_AI:
+				ai = new FireAi(record.target == NO_INDEX ? NULL : actors[record.target], values[0]);
+				break;
+			case NATURE_AI: {
+				NatureAi* natureAi = new NatureAi(values[1]);
+				natureAi->nbTurnsSinceCreation = values[0];
+				ai = natureAi;
+				break;
+			}
+			case BOT_AI:
+				ai = new BotAi();
+				break;
+		}
+		ais.push_back(ai);
+		if (monsterAi) {
+			monsterAi->wanderingTurn = values[0];
+			monsterAi->chasingTurn = values[1];
+			monsterAi->targetX = values[2];
+			monsterAi->targetY = values[3];
+			monsterAi->globalTurn = values[4];
+		}
+		if (temporaryAi) {
+			temporaryAi->oldAi = NULL;
+			if (record.oldAi != NO_INDEX) {
+				if (record.oldAi >= i || isReferenced[record.oldAi]) return false;
+				isReferenced[record.oldAi] = true;
+				temporaryAi->oldAi = ais[record.oldAi];
+			}
+		}
+		if (record.actor != NO_INDEX) {
+			if (isReferenced[i] || actors[record.actor]->ai) return false;
+			isReferenced[i] = true;
+			actors[record.actor]->ai = ai;
+		}
+	}
+	for (bool referenced : isReferenced)
+		if (!referenced) return false;
+	return true;
+}
+
+bool SaveGame::Reader::readNames() {
+	nameTracker = new NameTracker(new Random());
+	auto [names, nbNames] = table<NameRecord>(NAMES);
+	for (uint32_t i = 0; i < nbNames; i++) {
+		const NameRecord& record = names[i];
+		if (!isString(record.itemName) || !isString(record.defaultName, true) || !isString(record.callName, true))
+			return false;
+		Item::Kind kind = Item::getKindByName(stringAt(record.itemName));
+		if (kind == Item::NO_KIND) return false;
+		if (record.defaultName != NO_INDEX) {
+			// Default names point to the built-in ones, the saved one must be one of them
+			std::string_view defaultName = stringAt(record.defaultName);
+			const char* knownName = NULL;
+			for (const char* name : nameTracker->defaultNames)
+				if (defaultName == name) knownName = name;
+			if (!knownName) return false;
+			nameTracker->defaultNames[kind] = knownName;
+		}
+		if (record.flags & HAS_IDENTIFY_STATUS) nameTracker->isIdentified[kind] = record.flags & IDENTIFIED;
+		if ((record.flags & HAS_CALL_NAME) && record.callName != NO_INDEX)
+			nameTracker->setCallName(kind, stringAt(record.callName));
+	}
+	return true;
+}
+
+bool SaveGame::Reader::readLog() {
+	gui = new Gui();
+	auto [log, nbMessages] = table<LogRecord>(LOG);
+	for (uint32_t i = 0; i < nbMessages; i++) {
+		if (!isString(log[i].text)) return false;
+		auto text = reinterpret_cast<const char*>(data + sections[STRINGS]->offset + log[i].text);
+		gui->addLine(text, tcod::ColorRGB{log[i].r, log[i].g, log[i].b}, std::max(1, log[i].count));
+	}
+	return true;
+}
+
+bool SaveGame::Reader::readFloors(const EngineRecord& engineRecord) {
+	auto [records, nbFloors] = table<FloorRecord>(FLOORS);
+	auto [floorData, nbBytes] = table<uint8_t>(FLOOR_DATA);
+	floors.assign(nbFloors ? Content::NB_FLOORS + 1 : 0, {});
+	for (uint32_t i = 0; i < nbFloors; i++) {
+		// Snapshots are checked when their floor is entered again, here only that they are where they say
+		const FloorRecord& record = records[i];
+		if (record.level < 1 || record.level > Content::NB_FLOORS || record.level == engineRecord.level ||
+			!floors[record.level].empty() || record.size == 0 || record.offset > nbBytes ||
+			record.size > nbBytes - record.offset)
+			return false;
+		floors[record.level].assign(floorData + record.offset, floorData + record.offset + record.size);
+	}
+	return true;
+}
+
+// Replace the running game, nothing can fail from here on
+void SaveGame::Reader::commit(const EngineRecord& engineRecord) {
+	// Later floors of this run are the size of the saved one
+	engine.mapWidth = map->width;
+	engine.mapHeight = map->height;
+	engine.endGame();
+	auto [actorRecords, nbActors] = table<ActorRecord>(ACTORS);
+	for (uint32_t i = 0; i < nbActors; i++)
+		if (actorRecords[i].owner == NO_INDEX) engine.addActor(actors[i]);
+	engine.player = actors[engineRecord.player];
+	engine.stairs = actors[engineRecord.stairs];
+	engine.nature = engineRecord.nature == NO_INDEX ? NULL : actors[engineRecord.nature];
+	engine.upStairs = engineRecord.upStairs == NO_INDEX ? NULL : actors[engineRecord.upStairs];
+	engine.map = map;
+	engine.freeTiles.build(*map, engine.actors);
+	engine.visitedFloors = std::move(floors);
+	engine.gui = gui;
+	engine.nameTracker = nameTracker;
+	engine.level = engineRecord.level;
+	engine.monsterSpawnRate = engineRecord.monsterSpawnRate;
+	engine.fovRadius = engineRecord.fovRadius;
+	engine.winEffect = 0.0F;
+	engine.lastMouseTileX = engine.lastMouseTileY = 0;
+	engine.gameStatus = Engine::IDLE;
+	actors.clear();
+	ais.clear();
+	map = NULL;
+	gui = NULL;
+	nameTracker = NULL;
+	engine.map->computeFov();
+}
+
+// Replace the current floor, the player and the rest of the run stay
+void SaveGame::Reader::commitFloor(const EngineRecord& engineRecord) {
+	engine.clearFloor();
+	engine.removeActor(engine.stairs);
+	delete engine.stairs;
+	engine.removeActor(engine.player);
+	auto [actorRecords, nbActors] = table<ActorRecord>(ACTORS);
+	for (uint32_t i = 0; i < nbActors; i++)
+		if (actorRecords[i].owner == NO_INDEX) engine.addActor(actors[i]);
+	// Added last so the player is drawn over the floor
+	engine.addActor(engine.player);
+	engine.stairs = actors[engineRecord.stairs];
+	engine.nature = engineRecord.nature == NO_INDEX ? NULL : actors[engineRecord.nature];
+	engine.upStairs = engineRecord.upStairs == NO_INDEX ? NULL : actors[engineRecord.upStairs];
+	engine.map = map;
+	engine.freeTiles.build(*map, engine.actors);
+	actors.clear();
+	ais.clear();
+	map = NULL;
+}
+
+// Inflate a compressed save into out, false if data is not a valid compressed save
+static bool uncompressSave(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+	SaveGame::FileHeader header;
+	uint64_t rawSize;
+	if (size < sizeof(header) + sizeof(rawSize)) return false;
+	std::memcpy(&header, data, sizeof(header));
+	std::memcpy(&rawSize, data + sizeof(header), sizeof(rawSize));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != SaveGame::VERSION ||
+		header.endianTag != ENDIAN_TAG || header.fileSize != size || header.sectionCount != 0 ||
+		rawSize > SaveGame::MAX_UNCOMPRESSED_SIZE)
+		return false;
+	out.resize(rawSize);
+	uLongf outSize = (uLongf)rawSize;
+	size_t headerSize = sizeof(header) + sizeof(rawSize);
+	return uncompress(out.data(), &outSize, data + headerSize, (uLong)(size - headerSize)) == Z_OK &&
+		   outSize == rawSize;
+}
+
+bool SaveGame::read(const uint8_t* data, size_t size) {
+	if (size >= sizeof(FileHeader) && (reinterpret_cast<const FileHeader*>(data)->flags & COMPRESSED)) {
+		thread_local std::vector<uint8_t> uncompressed;
+		if (!uncompressSave(data, size, uncompressed)) return false;
+		data = uncompressed.data();
+		size = uncompressed.size();
+	}
+	Reader reader(data, size);
+	if (!reader.readHeaders(0)) return false;
+	const EngineRecord& engineRecord = *reader.table<EngineRecord>(ENGINE).first;
+	if (engineRecord.level < 1 || engineRecord.level > Content::NB_FLOORS || engineRecord.monsterSpawnRate <= 0)
+		return false;
+	if (!reader.readMap(engineRecord) || !reader.readActors() || !reader.readAis() || !reader.readNames() ||
+		!reader.readLog() || !reader.readFloors(engineRecord))
+		return false;
+	// Player and stairs must be on the map, and the player must be able to play
+	if (!reader.isOnMap(engineRecord.player) || !reader.isOnMap(engineRecord.stairs) ||
+		!reader.isOnMap(engineRecord.nature, true) || !reader.isOnMap(engineRecord.upStairs, true))
+		return false;
+	Actor* player = reader.actors[engineRecord.player];
+	if (!player->destructible || !player->ai || !player->container) return false;
+	reader.commit(engineRecord);
+	return true;
+}
+
+bool SaveGame::writeFloor(std::vector<uint8_t>& out) {
+	// Floors are written one at a time, the raw buffer is kept between calls
+	thread_local std::vector<uint8_t> buffer;
+	write(buffer, true);
+	return compress(buffer, out);
+}
+
+bool SaveGame::readFloor(const uint8_t* data, size_t size) {
+	thread_local std::vector<uint8_t> uncompressed;
+	if (!uncompressSave(data, size, uncompressed)) return false;
+	Reader reader(uncompressed.data(), uncompressed.size());
+	if (!reader.readHeaders(FLOOR)) return false;
+	// A snapshot belongs to the floor being entered and is as large as the floors of the run
+	const EngineRecord& engineRecord = *reader.table<EngineRecord>(ENGINE).first;
+	if (engineRecord.level != engine.level || engineRecord.mapWidth != engine.mapWidth ||
+		engineRecord.mapHeight != engine.mapHeight)
+		return false;
+	if (!reader.readMap(engineRecord) || !reader.readActors() || !reader.readAis()) return false;
+	if (engineRecord.player != NO_INDEX || !reader.isOnMap(engineRecord.stairs) ||
+		!reader.isOnMap(engineRecord.nature, true) || !reader.isOnMap(engineRecord.upStairs, true))
+		return false;
+	reader.commitFloor(engineRecord);
+	return true;
+}
+
+bool SaveGame::compress(const std::vector<uint8_t>& save, std::vector<uint8_t>& out, int level) {
+	FileHeader header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.endianTag = ENDIAN_TAG;
+	header.flags = COMPRESSED;
+	uint64_t rawSize = save.size();
+	size_t headerSize = sizeof(header) + sizeof(rawSize);
+
+	uLongf streamSize = compressBound((uLong)save.size());
+	out.resize(headerSize + streamSize);
+	if (compress2(out.data() + headerSize, &streamSize, save.data(), (uLong)save.size(), level) != Z_OK) return false;
+	out.resize(headerSize + streamSize);
+	header.fileSize = out.size();
+	std::memcpy(out.data(), &header, sizeof(header));
+	std::memcpy(out.data() + sizeof(header), &rawSize, sizeof(rawSize));
+	return true;
+}
+
+bool SaveGame::save(const std::filesystem::path& path) {
+	std::vector<uint8_t> buffer, compressed;
+	write(buffer);
+	return compress(buffer, compressed) && AtomicFile::write(path, compressed.data(), compressed.size());
+}
+
+bool SaveGame::load(const std::filesystem::path& path) {
+	MappedFile file(path);
+	return file.isOpen() && read(file.data(), file.size());
+}
@@ -0,0 +1,48 @@
+#include "spatialindex.hpp"
+
+#include <cassert>
+
+#include "main.hpp"
+
+SpatialIndex::SpatialIndex(int width, int height) { reset(width, height); }
+
+SpatialIndex::~SpatialIndex() { reset(0, 0); }
+
+void SpatialIndex::reset(int width, int height) {
+	for (auto& cell : cells)
+		for (const Entry& entry : cell) entry.actor->spatialIndex = NULL;
+	gridWidth = std::max(1, (width + CELL_SIZE - 1) / CELL_SIZE);
+	gridHeight = std::max(1, (height + CELL_SIZE - 1) / CELL_SIZE);
+	cells.assign(gridWidth * gridHeight, {});
+	nbActors = 0;
+}
+
+void SpatialIndex::insert(Actor* actor) {
+	assert(actor->spatialIndex == NULL);
+	actor->spatialIndex = this;
+	cellAt(actor->x, actor->y).push_back({actor, actor->x, actor->y});
+	nbActors++;
+}
+
+void SpatialIndex::remove(Actor* actor) {
+	assert(actor->spatialIndex == this);
+	auto& cell = cellAt(actor->x, actor->y);
+	// Erased rather than swapped with the last one, so queries keep visiting actors in insertion order
+	cell.erase(std::find_if(cell.begin(), cell.end(), [&](const Entry& entry) { return entry.actor == actor; }));
+	actor->spatialIndex = NULL;
+	nbActors--;
+}
+
+void SpatialIndex::move(Actor* actor, int oldX, int oldY) {
+	auto& oldCell = cellAt(oldX, oldY);
+	auto it = std::find_if(oldCell.begin(), oldCell.end(), [&](const Entry& entry) { return entry.actor == actor; });
+	assert(it != oldCell.end());
+	auto& newCell = cellAt(actor->x, actor->y);
+	if (&newCell == &oldCell) {
+		it->x = actor->x;
+		it->y = actor->y;
+		return;
+	}
+	oldCell.erase(it);
+	newCell.push_back({actor, actor->x, actor->y});
+}
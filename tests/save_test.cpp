@@ -0,0 +1,89 @@
+// Save round trip test, run by ctest.
+// Saves a generated game that has left a floor behind, loads it back from its compressed and raw forms and checks
+// that saving it again gives the same bytes. Then checks that truncated saves, sections pointing out of the file,
+// actors off the map and damaged compressed streams are all rejected, leaving the running game as it was.
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "main.hpp"
+
+static int nbFailures = 0;
+
+static void check(bool condition, const char* what) {
+	std::printf("%s: %s\n", condition ? "ok" : "FAILED", what);
+	if (!condition) nbFailures++;
+}
+
+// Whether the running game saves to exactly expected
+static bool isGame(const std::vector<uint8_t>& expected) {
+	std::vector<uint8_t> saved;
+	SaveGame::write(saved);
+	return saved == expected;
+}
+
+static SaveGame::SectionHeader& sectionHeader(std::vector<uint8_t>& save, SaveGame::SectionId id) {
+	auto headers = reinterpret_cast<SaveGame::SectionHeader*>(save.data() + sizeof(SaveGame::FileHeader));
+	return headers[id];
+}
+
+static SaveGame::ActorRecord* actorRecords(std::vector<uint8_t>& save) {
+	return reinterpret_cast<SaveGame::ActorRecord*>(save.data() + sectionHeader(save, SaveGame::ACTORS).offset);
+}
+
+// A copy of save damaged by damage must fail to load and leave the running game untouched
+static void checkRejected(
+	const std::vector<uint8_t>& save, const char* what, std::function<void(std::vector<uint8_t>&)> damage) {
+	std::vector<uint8_t> damaged = save;
+	damage(damaged);
+	bool isLoaded = SaveGame::read(damaged.data(), damaged.size());
+	check(!isLoaded && isGame(save), what);
+}
+
+int main() {
+	Random::instance().resetSeed(12345);
+	engine.newGame();
+	engine.map->computeFov();
+	// Leave the first floor so the save holds a floor snapshot too
+	engine.player->moveTo(engine.stairs->x, engine.stairs->y);
+	engine.nextLevel();
+	engine.map->computeFov();
+
+	std::vector<uint8_t> saved, compressed;
+	SaveGame::write(saved);
+	check(SaveGame::compress(saved, compressed), "compress the save");
+	size_t nbActors = engine.actors.size();
+	int level = engine.level;
+
+	check(SaveGame::read(compressed.data(), compressed.size()), "load the compressed save");
+	check(engine.level == level && engine.actors.size() == nbActors, "same floor and actors after loading");
+	check(isGame(saved), "saving the loaded game gives the same bytes");
+	check(SaveGame::read(saved.data(), saved.size()) && isGame(saved), "load the raw save");
+
+	for (size_t size : {(size_t)0, sizeof(SaveGame::FileHeader), saved.size() / 2, saved.size() - 1})
+		checkRejected(saved, "reject a truncated save", [size](std::vector<uint8_t>& save) { save.resize(size); });
+	checkRejected(saved, "reject a section past the end of the file", [](std::vector<uint8_t>& save) {
+		sectionHeader(save, SaveGame::ACTORS).offset = save.size();
+	});
+	checkRejected(saved, "reject a section with too many records", [](std::vector<uint8_t>& save) {
+		sectionHeader(save, SaveGame::ACTORS).count++;
+	});
+	checkRejected(saved, "reject an actor off the map", [](std::vector<uint8_t>& save) {
+		actorRecords(save)[0].x = engine.map->width;
+	});
+	checkRejected(saved, "reject a string offset out of the strings", [](std::vector<uint8_t>& save) {
+		actorRecords(save)[0].name = sectionHeader(save, SaveGame::STRINGS).count;
+	});
+	checkRejected(compressed, "reject a damaged compressed stream", [](std::vector<uint8_t>& save) {
+		save[save.size() / 2] ^= 0xFF;
+	});
+	checkRejected(compressed, "reject a truncated compressed save", [](std::vector<uint8_t>& save) {
+		save.resize(save.size() - 1);
+	});
+
+	engine.endGame();
+	std::printf("%d failed\n", nbFailures);
+	return nbFailures == 0 ? 0 : 1;
+}
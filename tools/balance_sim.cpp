@@ -0,0 +1,329 @@
+// Headless Monte-Carlo balance simulator.
+// Plays many full games in parallel with the BotAi player and no rendering, then reports survival per floor, causes
+// of death, item usage and turn throughput. With --check-saves it also round-trips the game through the save format
+// at regular intervals, checking that saving the loaded game gives back the same bytes, and with --autosave it runs
+// the background autosave to measure how long the game is held up by it.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "main.hpp"
+#include "toolsupport.hpp"
+
+struct GameResult {
+	unsigned seed;
+	int floorReached;
+	bool won;
+	bool timedOut;
+	std::string causeOfDeath;
+	int turns;
+	double seconds;
+	std::map<std::string, int> itemUses;
+	int saveChecks;
+	int saveMismatches;
+	double loadUsTotal, loadUsMax;
+	size_t saveBytesMax;
+	AutoSaver::Stats autoSave;
+};
+
+struct Options {
+	int games = 1000;
+	int threads = 0;
+	int maxTurns = 50000;
+	unsigned seed = 12345;
+	int checkSavesEvery = 0;
+	int autoSaveEvery = 0;
+	std::string logDir;
+	std::string csvPath;
+};
+
+static void printUsage() {
+	std::printf(
+		"Usage: balance-sim [--games N] [--threads T] [--seed S] [--max-turns M] [--check-saves N] [--autosave N]\n"
+		"                   [--export-logs DIR] [--csv PATH]\n"
+		"  --games N      games to play (default 1000)\n"
+		"  --threads T    worker threads (default: all cores)\n"
+		"  --seed S       base seed, game i uses seed S + i (default 12345)\n"
+		"  --max-turns M  give up on a game after M turns (default 50000)\n"
+		"  --check-saves N  save and reload every N turns, verifying the round trip (default off)\n"
+		"  --autosave N   autosave to a temporary file every N turns and report its cost (default off)\n"
+		"  --export-logs DIR  write the last messages of each game to DIR/game-SEED.jsonl as structured events\n"
+		"  --csv PATH     also write one row per game\n");
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--games" && hasValue) {
+			options.games = std::atoi(argv[++i]);
+		} else if (arg == "--threads" && hasValue) {
+			options.threads = std::atoi(argv[++i]);
+		} else if (arg == "--max-turns" && hasValue) {
+			options.maxTurns = std::atoi(argv[++i]);
+		} else if (arg == "--check-saves" && hasValue) {
+			options.checkSavesEvery = std::atoi(argv[++i]);
+		} else if (arg == "--autosave" && hasValue) {
+			options.autoSaveEvery = std::atoi(argv[++i]);
+		} else if (arg == "--export-logs" && hasValue) {
+			options.logDir = argv[++i];
+		} else if (arg == "--csv" && hasValue) {
+			options.csvPath = argv[++i];
+		} else if (!parseSeedOption(argc, argv, i, options.seed)) {
+			return false;
+		}
+	}
+	return options.games > 0 && options.maxTurns > 0 && options.checkSavesEvery >= 0 &&
+		   options.autoSaveEvery >= 0;
+}
+
+// Save the running game, load it back from its compressed form and save it again. Both saves must be identical.
+// Returns the new bot.
+static BotAi* checkSaveRoundTrip(BotAi* bot, GameResult& result) {
+	thread_local std::vector<uint8_t> saved, compressed, resaved;
+	SaveGame::write(saved);
+	auto itemUses = bot->itemUses;
+	if (!SaveGame::compress(saved, compressed)) {
+		result.saveChecks++;
+		result.saveMismatches++;
+		return bot;
+	}
+	auto start = std::chrono::steady_clock::now();
+	bool isLoaded = SaveGame::read(compressed.data(), compressed.size());
+	double loadUs = elapsedUs(start);
+	result.saveChecks++;
+	result.loadUsTotal += loadUs;
+	result.loadUsMax = std::max(result.loadUsMax, loadUs);
+	result.saveBytesMax = std::max(result.saveBytesMax, saved.size());
+	if (!isLoaded) {
+		result.saveMismatches++;
+		return bot;
+	}
+	SaveGame::write(resaved);
+	if (resaved != saved) result.saveMismatches++;
+	// Loading created a new bot and gui
+	bot = static_cast<BotAi*>(engine.player->ai);
+	engine.gui->disableHistory();
+	bot->itemUses = itemUses;
+	return bot;
+}
+
+// Play one full game on this thread's engine
+static GameResult playGame(unsigned seed, const Options& options) {
+	auto start = std::chrono::steady_clock::now();
+	AutoSaver* autoSaver = NULL;
+	std::filesystem::path autoSavePath;
+	if (options.autoSaveEvery) {
+		auto threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+		autoSavePath = std::filesystem::temp_directory_path() / ("balance-sim-" + std::to_string(threadId) + ".sav");
+		autoSaver = new AutoSaver(autoSavePath);
+	}
+	Random::instance().resetSeed(seed);
+	engine.newGame();
+	engine.gui->disableHistory();
+	delete engine.player->ai;
+	BotAi* bot = new BotAi();
+	engine.player->ai = bot;
+	// Confusion replaces the bot with ConfusedPlayerAi for a while, which reads the keyboard: feed it a move
+	engine.lastEventType = SDL_EVENT_KEY_DOWN;
+	engine.lastKeyboardEvent.key = SDLK_H;
+	engine.map->computeFov();
+
+	GameResult result = {};
+	result.seed = seed;
+	while (result.turns < options.maxTurns) {
+		engine.gameStatus = Engine::PLAYER_TURN;
+		engine.player->update();
+		if (engine.gameStatus == Engine::VICTORY) break;
+		if (engine.gameStatus == Engine::OTHER_ACTORS_TURN) {
+			engine.updateOtherActors();
+			result.turns++;
+			// Only while the bot is in control, so it can be found again after loading
+			if (options.checkSavesEvery && result.turns % options.checkSavesEvery == 0 && engine.player->ai == bot &&
+				!engine.player->destructible->isDead())
+				bot = checkSaveRoundTrip(bot, result);
+			if (autoSaver && result.turns % options.autoSaveEvery == 0) autoSaver->snapshot();
+		}
+		if (engine.player->destructible->isDead()) break;
+	}
+	result.floorReached = engine.level;
+	result.won = engine.gameStatus == Engine::VICTORY;
+	if (engine.player->destructible->isDead()) {
+		const char* source = engine.player->destructible->lastDamageSource;
+		result.causeOfDeath = source ? source : "unknown";
+	}
+	result.timedOut = !result.won && result.causeOfDeath.empty();
+	if (!options.logDir.empty()) {
+		auto path = std::filesystem::path(options.logDir) / ("game-" + std::to_string(seed) + ".jsonl");
+		if (FILE* file = std::fopen(path.string().c_str(), "w")) {
+			engine.gui->exportLog(file);
+			std::fclose(file);
+		}
+	}
+	// The bot is only reachable while it is not replaced by a temporary ai
+	if (engine.player->ai == bot) result.itemUses = bot->itemUses;
+	engine.endGame();
+	if (autoSaver) {
+		autoSaver->flush();
+		result.autoSave = autoSaver->getStats();
+		delete autoSaver;
+		std::error_code error;
+		std::filesystem::remove(autoSavePath, error);
+	}
+	result.seconds = elapsedUs(start) / 1e6;
+	return result;
+}
+
+static bool writeCsv(const std::string& path, const std::vector<GameResult>& results) {
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (!file) return false;
+	std::fprintf(file, "seed,floor_reached,won,timed_out,cause_of_death,turns,seconds\n");
+	for (const auto& result : results)
+		std::fprintf(
+			file,
+			"%u,%d,%d,%d,%s,%d,%.4f\n",
+			result.seed,
+			result.floorReached,
+			result.won ? 1 : 0,
+			result.timedOut ? 1 : 0,
+			result.causeOfDeath.c_str(),
+			result.turns,
+			result.seconds);
+	std::fclose(file);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	int nbThreads = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<GameResult> results(options.games);
+	std::atomic<int> nextGame = 0;
+	auto worker = [&]() {
+		for (int game = nextGame++; game < options.games; game = nextGame++)
+			results[game] = playGame(options.seed + (unsigned)game, options);
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int i = 0; i < nbThreads; i++) threads.emplace_back(worker);
+	for (auto& thread : threads) thread.join();
+	double elapsedS = elapsedUs(start) / 1e6;
+
+	long long totalTurns = 0;
+	double totalGameSeconds = 0.0;
+	int wins = 0, timeouts = 0;
+	int reached[Content::NB_FLOORS + 1] = {};
+	int diedOn[Content::NB_FLOORS + 1] = {};
+	std::map<std::string, int> deaths;
+	std::map<std::string, int> itemUses;
+	for (const auto& result : results) {
+		totalTurns += result.turns;
+		totalGameSeconds += result.seconds;
+		if (result.won) wins++;
+		if (result.timedOut) timeouts++;
+		for (int floor = 1; floor <= result.floorReached; floor++) reached[floor]++;
+		if (!result.causeOfDeath.empty()) {
+			diedOn[result.floorReached]++;
+			deaths[result.causeOfDeath]++;
+		}
+		for (const auto& [name, uses] : result.itemUses) itemUses[name] += uses;
+	}
+
+	int games = options.games;
+	std::printf("Played %d games on %d threads in %.2fs\n", games, nbThreads, elapsedS);
+	std::printf(
+		"Won %d (%.1f%%), timed out %d, average %.0f turns per game\n",
+		wins,
+		100.0 * wins / games,
+		timeouts,
+		(double)totalTurns / games);
+	std::printf(
+		"Throughput: %.0f turns/s per core, %.0f turns/s overall\n",
+		totalGameSeconds > 0 ? totalTurns / totalGameSeconds : 0.0,
+		elapsedS > 0 ? totalTurns / elapsedS : 0.0);
+
+	if (options.checkSavesEvery) {
+		int checks = 0, mismatches = 0;
+		double loadUsTotal = 0.0, loadUsMax = 0.0;
+		size_t saveBytesMax = 0;
+		for (const auto& result : results) {
+			checks += result.saveChecks;
+			mismatches += result.saveMismatches;
+			loadUsTotal += result.loadUsTotal;
+			loadUsMax = std::max(loadUsMax, result.loadUsMax);
+			saveBytesMax = std::max(saveBytesMax, result.saveBytesMax);
+		}
+		std::printf(
+			"Save round trips: %d, failed %d, load %.1fus average %.1fus max, largest save %zu bytes\n",
+			checks,
+			mismatches,
+			checks ? loadUsTotal / checks : 0.0,
+			loadUsMax,
+			saveBytesMax);
+	}
+
+	if (options.autoSaveEvery) {
+		AutoSaver::Stats total;
+		size_t saveBytes = 0, compressedBytes = 0;
+		for (const auto& result : results) {
+			const auto& stats = result.autoSave;
+			total.snapshots += stats.snapshots;
+			total.writes += stats.writes;
+			total.failedWrites += stats.failedWrites;
+			total.snapshotUsTotal += stats.snapshotUsTotal;
+			total.snapshotUsMax = std::max(total.snapshotUsMax, stats.snapshotUsMax);
+			total.writeUsTotal += stats.writeUsTotal;
+			total.writeUsMax = std::max(total.writeUsMax, stats.writeUsMax);
+			saveBytes += stats.lastSaveBytes;
+			compressedBytes += stats.lastCompressedBytes;
+		}
+		std::printf(
+			"Autosave: %d snapshots, game held up %.1fus average %.1fus max, %d background writes (%d failed) "
+			"%.1fus average %.1fus max, compressed to %.0f%%\n",
+			total.snapshots,
+			total.snapshots ? total.snapshotUsTotal / total.snapshots : 0.0,
+			total.snapshotUsMax,
+			total.writes,
+			total.failedWrites,
+			total.writes ? total.writeUsTotal / total.writes : 0.0,
+			total.writeUsMax,
+			saveBytes ? 100.0 * compressedBytes / saveBytes : 0.0);
+	}
+
+	std::printf("\nSurvival per floor\n  floor  reached  died here\n");
+	for (int floor = 1; floor <= Content::NB_FLOORS; floor++)
+		std::printf("  %5d  %6.1f%%  %8.1f%%\n", floor, 100.0 * reached[floor] / games, 100.0 * diedOn[floor] / games);
+
+	std::printf("\nCauses of death\n");
+	std::vector<std::pair<int, std::string>> sortedDeaths;
+	for (const auto& [name, count] : deaths) sortedDeaths.push_back({count, name});
+	std::sort(sortedDeaths.rbegin(), sortedDeaths.rend());
+	for (const auto& [count, name] : sortedDeaths)
+		std::printf("  %-20s %6d  %5.1f%%\n", name.c_str(), count, 100.0 * count / games);
+
+	std::printf("\nItem uses per game\n");
+	for (const auto& [name, uses] : itemUses) std::printf("  %-26s %6.2f\n", name.c_str(), (double)uses / games);
+
+	if (!options.csvPath.empty()) {
+		if (!writeCsv(options.csvPath, results)) {
+			std::fprintf(stderr, "Could not write %s\n", options.csvPath.c_str());
+			return 1;
+		}
+		std::printf("\nWrote %s\n", options.csvPath.c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,144 @@
+// Floor switching benchmark.
+// Plays a run down through all 20 floors and back up to the first, several times over. Every switch snapshots the
+// floor left and generates or restores the one entered, and is timed by kind. Reports the size of the compressed
+// snapshots kept for every floor, and checks that floors come back with the actors they were left with. Last, saves
+// the run with the snapshots of all its floors and loads it back, which with --map-size 4096x4096 is the largest
+// save a run can make.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "main.hpp"
+#include "toolsupport.hpp"
+
+struct Options {
+	int rounds = 5;
+	int mapWidth = Engine::MAP_WIDTH, mapHeight = Engine::MAP_HEIGHT;
+	unsigned seed = 12345;
+};
+
+static void printUsage() {
+	std::printf(
+		"Usage: floor-bench [--rounds N] [--map-size WxH] [--seed S]\n"
+		"  --rounds N      trips down to floor 20 and back up (default 5)\n"
+		"  --map-size WxH  size of every floor (default %dx%d)\n"
+		"  --seed S        seed of the run (default 12345)\n",
+		Engine::MAP_WIDTH,
+		Engine::MAP_HEIGHT);
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--rounds" && hasValue) {
+			options.rounds = std::atoi(argv[++i]);
+		} else if (
+			!parseMapSizeOption(argc, argv, i, options.mapWidth, options.mapHeight) &&
+			!parseSeedOption(argc, argv, i, options.seed)) {
+			return false;
+		}
+	}
+	return options.rounds > 0;
+}
+
+static void printTimes(const char* kind, const std::vector<double>& ms) {
+	std::printf(
+		"  %-9s %6d %9.3f %9.3f %9.3f\n",
+		kind,
+		(int)ms.size(),
+		percentile(ms, 0.5),
+		percentile(ms, 0.99),
+		ms.empty() ? 0.0 : *std::max_element(ms.begin(), ms.end()));
+}
+
+// Uncompressed size stored in a snapshot, after its header
+static uint64_t rawSize(const std::vector<uint8_t>& snapshot) {
+	uint64_t size = 0;
+	if (snapshot.size() >= sizeof(SaveGame::FileHeader) + sizeof(size))
+		std::memcpy(&size, snapshot.data() + sizeof(SaveGame::FileHeader), sizeof(size));
+	return size;
+}
+
+// Save the running game, load it back from its compressed form and save it again. Both saves must be identical.
+static bool checkSaveRoundTrip() {
+	std::vector<uint8_t> saved, compressed, resaved;
+	SaveGame::write(saved);
+	bool isLoaded = SaveGame::compress(saved, compressed) && SaveGame::read(compressed.data(), compressed.size());
+	if (isLoaded) SaveGame::write(resaved);
+	std::printf(
+		"Save of the run: %llu B raw (largest read %llu B), %llu B compressed, loaded back: %s\n",
+		(unsigned long long)saved.size(),
+		(unsigned long long)SaveGame::MAX_UNCOMPRESSED_SIZE,
+		(unsigned long long)compressed.size(),
+		!isLoaded ? "no" : resaved == saved ? "yes" : "with differences");
+	return isLoaded && resaved == saved;
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	Random::instance().resetSeed(options.seed);
+	engine.mapWidth = options.mapWidth;
+	engine.mapHeight = options.mapHeight;
+	engine.newGame();
+	engine.map->computeFov();
+	engine.gameStatus = Engine::IDLE;
+
+	std::vector<double> generateMs, restoreMs;
+	std::vector<uint64_t> compressedSizes(Content::NB_FLOORS + 1, 0), rawSizes(Content::NB_FLOORS + 1, 0);
+	// Actors on every floor when the player left it, to compare with what is there when coming back
+	std::vector<size_t> actorsLeft(Content::NB_FLOORS + 1, 0);
+	int mismatches = 0;
+	auto switchLevel = [&](bool isGoingDown) {
+		Actor* exit = isGoingDown ? engine.stairs : engine.upStairs;
+		engine.player->moveTo(exit->x, exit->y);
+		int from = engine.level, to = isGoingDown ? from + 1 : from - 1;
+		bool isVisited = (size_t)to < engine.visitedFloors.size() && !engine.visitedFloors[to].empty();
+		actorsLeft[from] = engine.actors.size();
+		auto start = std::chrono::steady_clock::now();
+		if (isGoingDown)
+			engine.nextLevel();
+		else
+			engine.previousLevel();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		(isVisited ? restoreMs : generateMs).push_back(ms);
+		if (isVisited && engine.actors.size() != actorsLeft[to]) mismatches++;
+		const std::vector<uint8_t>& snapshot = engine.visitedFloors[from];
+		compressedSizes[from] = snapshot.size();
+		rawSizes[from] = rawSize(snapshot);
+	};
+	for (int round = 0; round < options.rounds; round++) {
+		while (engine.level < Content::NB_FLOORS) switchLevel(true);
+		while (engine.level > 1) switchLevel(false);
+	}
+
+	std::printf("Floors of %dx%d, %d rounds\n", options.mapWidth, options.mapHeight, options.rounds);
+	std::printf("  %-9s %6s %9s %9s %9s\n", "switch", "count", "p50 ms", "p99 ms", "max ms");
+	printTimes("generate", generateMs);
+	printTimes("restore", restoreMs);
+	std::printf("  %-5s %12s %12s\n", "floor", "snapshot B", "raw B");
+	uint64_t totalCompressed = 0, totalRaw = 0;
+	for (int level = 1; level <= Content::NB_FLOORS; level++) {
+		std::printf(
+			"  %-5d %12llu %12llu\n",
+			level,
+			(unsigned long long)compressedSizes[level],
+			(unsigned long long)rawSizes[level]);
+		totalCompressed += compressedSizes[level];
+		totalRaw += rawSizes[level];
+	}
+	std::printf("  %-5s %12llu %12llu\n", "total", (unsigned long long)totalCompressed, (unsigned long long)totalRaw);
+	std::printf("Floors restored with a different actor count: %d\n", mismatches);
+	bool isSaved = checkSaveRoundTrip();
+	engine.endGame();
+	return mismatches == 0 && isSaved ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+// Map size scaling benchmark.
+// Generates a first floor at sizes from the default 72x32 up to 4096x4096, then times drawing the view and playing
+// turns with the player walking at random among the monsters. Floors hold as many monsters and items per tile at
+// every size, so render and turn times staying flat show that only the view and the active range are looked at.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "main.hpp"
+#include "toolsupport.hpp"
+
+struct Options {
+	int frames = 500;
+	int turns = 500;
+	int maxSize = Map::MAX_SIZE;
+	unsigned seed = 12345;
+};
+
+static void printUsage() {
+	std::printf(
+		"Usage: map-bench [--frames N] [--turns N] [--max-size N] [--seed S]\n"
+		"  --frames N    frames drawn per size (default 500)\n"
+		"  --turns N     turns played per size (default 500)\n"
+		"  --max-size N  largest square map side (default %d)\n"
+		"  --seed S      seed of every floor and walk (default 12345)\n",
+		Map::MAX_SIZE);
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--frames" && hasValue) {
+			options.frames = std::atoi(argv[++i]);
+		} else if (arg == "--turns" && hasValue) {
+			options.turns = std::atoi(argv[++i]);
+		} else if (arg == "--max-size" && hasValue) {
+			options.maxSize = std::atoi(argv[++i]);
+		} else if (!parseSeedOption(argc, argv, i, options.seed)) {
+			return false;
+		}
+	}
+	return options.frames > 0 && options.turns > 0 && options.maxSize >= Map::MIN_SIZE &&
+		   options.maxSize <= Map::MAX_SIZE;
+}
+
+// Step the player to a random free neighbour, then let every other actor play
+static void playTurn() {
+	Actor* player = engine.player;
+	Random& rng = Random::instance();
+	int dx = rng.getInt(-1, 1), dy = rng.getInt(-1, 1);
+	if (engine.map->canWalk(player->x + dx, player->y + dy)) player->moveTo(player->x + dx, player->y + dy);
+	engine.map->computeFov();
+	engine.updateOtherActors();
+	// Keep walking whatever the monsters do
+	player->destructible->hp = player->destructible->maxHp;
+}
+
+static void run(int width, int height, const Options& options) {
+	Random::instance().resetSeed(options.seed);
+	engine.mapWidth = width;
+	engine.mapHeight = height;
+	auto start = std::chrono::steady_clock::now();
+	engine.newGame();
+	double generationMs = elapsedUs(start) / 1000.0;
+	engine.map->computeFov();
+	engine.gameStatus = Engine::IDLE;
+	int nbActors = (int)engine.actors.size();
+
+	tcod::Console console{Engine::CONSOLE_WIDTH, Engine::CONSOLE_HEIGHT};
+	std::vector<double> frameUs, turnUs;
+	for (int i = 0; i < options.frames; i++) {
+		start = std::chrono::steady_clock::now();
+		console.clear();
+		engine.render(console);
+		frameUs.push_back(elapsedUs(start));
+	}
+	int turns = 0;
+	for (; turns < options.turns && !engine.player->destructible->isDead(); turns++) {
+		start = std::chrono::steady_clock::now();
+		playTurn();
+		turnUs.push_back(elapsedUs(start));
+	}
+	std::printf(
+		"  %-11s %9.1f %8d %9.1f %9.1f %9.1f %9.1f %6d\n",
+		tcod::stringf("%dx%d", width, height).c_str(),
+		generationMs,
+		nbActors,
+		percentile(frameUs, 0.5),
+		percentile(frameUs, 0.99),
+		percentile(turnUs, 0.5),
+		percentile(turnUs, 0.99),
+		turns);
+	engine.endGame();
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	std::printf(
+		"  %-11s %9s %8s %9s %9s %9s %9s %6s\n",
+		"map",
+		"gen ms",
+		"actors",
+		"frame p50",
+		"frame p99",
+		"turn p50",
+		"turn p99",
+		"turns");
+	run(Engine::MAP_WIDTH, Engine::MAP_HEIGHT, options);
+	for (int side = 256; side <= options.maxSize; side *= 2) run(side, side, options);
+	std::printf("Frame and turn times in us\n");
+	return 0;
+}
@@ -0,0 +1,190 @@
+// Map generator benchmark.
+// Generates the same floors with every map generator in turn, through the regular Map::Map path, and compares how
+// long each takes against the layouts it produces. Then times one step of the cave automaton on packed rows against
+// a tile by tile count, and checks that both give the same board.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "main.hpp"
+#include "toolsupport.hpp"
+
+struct Options {
+	int floors = 200;
+	int level = 1;
+	int mapWidth = Engine::MAP_WIDTH, mapHeight = Engine::MAP_HEIGHT;
+	unsigned seed = 12345;
+};
+
+struct FloorStats {
+	double generationUs;  // the whole floor, contents included
+	double layoutUs;  // digging the layout only
+	double connectivityUs;
+	int walkable, rooms, components, filledTiles, farthestDistance, stairsDistance;
+	int deadEnds;  // walkable tiles with a single walkable neighbour
+};
+
+static void printUsage() {
+	std::printf(
+		"Usage: mapgen-bench [--floors N] [--level L] [--map-size WxH] [--seed S]\n"
+		"  --floors N      floors generated per generator (default 200)\n"
+		"  --level L       floor whose table is used (default 1)\n"
+		"  --map-size WxH  size of the floors (default %dx%d)\n"
+		"  --seed S        seed of the first floor, the others follow (default 12345)\n",
+		Engine::MAP_WIDTH,
+		Engine::MAP_HEIGHT);
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--floors" && hasValue) {
+			options.floors = std::atoi(argv[++i]);
+		} else if (arg == "--level" && hasValue) {
+			options.level = std::atoi(argv[++i]);
+		} else if (
+			!parseMapSizeOption(argc, argv, i, options.mapWidth, options.mapHeight) &&
+			!parseSeedOption(argc, argv, i, options.seed)) {
+			return false;
+		}
+	}
+	return options.floors > 0 && options.level >= 1 && options.level <= Content::NB_FLOORS;
+}
+
+template <typename Getter>
+static double median(const std::vector<FloorStats>& floors, Getter getter) {
+	std::vector<double> values;
+	for (const auto& floor : floors) values.push_back((double)getter(floor));
+	return percentile(values, 0.5);
+}
+
+static FloorStats generateFloor(const Options& options, unsigned seed) {
+	engine.clearFloor();
+	engine.level = options.level;
+	Random::instance().resetSeed(seed);
+	auto start = std::chrono::steady_clock::now();
+	engine.map = new Map(engine.mapWidth, engine.mapHeight);
+	FloorStats stats = {};
+	stats.generationUs = elapsedUs(start);
+
+	const Map& map = *engine.map;
+	stats.layoutUs = map.layoutStats.generateUs;
+	stats.connectivityUs = map.layoutStats.passUs;
+	stats.rooms = (int)map.rooms.size();
+	stats.components = map.layoutStats.components;
+	stats.filledTiles = map.layoutStats.filledTiles;
+	stats.farthestDistance = map.layoutStats.farthestDistance;
+	stats.stairsDistance = map.layoutStats.stairsDistance;
+	for (int y = 0; y < map.height; y++)
+		for (int x = 0; x < map.width; x++) {
+			if (!map.isWalkable(x, y)) continue;
+			stats.walkable++;
+			int neighbours = 0;
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++) neighbours += (dx || dy) && map.isWalkable(x + dx, y + dy);
+			if (neighbours == 1) stats.deadEnds++;
+		}
+	return stats;
+}
+
+// Same rule as CaveGenerator::step(), one tile at a time
+static void naiveStep(const BitBoard& walls, BitBoard& next) {
+	int x1 = walls.getX(), y1 = walls.getY();
+	for (int y = y1; y < y1 + walls.getHeight(); y++)
+		for (int x = x1; x < x1 + walls.getWidth(); x++) {
+			int count = 0;
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++) {
+					int nx = x + dx, ny = y + dy;
+					bool isOff = nx < x1 || ny < y1 || nx >= x1 + walls.getWidth() || ny >= y1 + walls.getHeight();
+					count += isOff || walls.get(nx, ny);
+				}
+			next.set(x, y, count >= 5);
+		}
+}
+
+static void benchCaveStep(const Options& options) {
+	Random& rng = Random::instance();
+	rng.resetSeed(options.seed);
+	BitBoard walls(0, 0, options.mapWidth, options.mapHeight);
+	BitBoard packed = walls, naive = walls;
+	for (int y = 0; y < options.mapHeight; y++)
+		for (int x = 0; x < options.mapWidth; x++)
+			if (rng.getBool(0.45)) walls.set(x, y);
+	int rounds = std::max(1, 2000000 / (options.mapWidth * options.mapHeight));
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < rounds; i++) CaveGenerator::step(walls, packed);
+	double packedUs = elapsedUs(start) / rounds;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < rounds; i++) naiveStep(walls, naive);
+	double naiveUs = elapsedUs(start) / rounds;
+	int mismatches = 0;
+	for (int y = 0; y < options.mapHeight; y++)
+		for (int x = 0; x < options.mapWidth; x++) mismatches += packed.get(x, y) != naive.get(x, y);
+	std::printf(
+		"Cave step on %dx%d: packed %.2f us, tile by tile %.2f us (x%.1f), mismatching tiles: %d\n",
+		options.mapWidth,
+		options.mapHeight,
+		packedUs,
+		naiveUs,
+		packedUs > 0.0 ? naiveUs / packedUs : 0.0,
+		mismatches);
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	engine.mapWidth = options.mapWidth;
+	engine.mapHeight = options.mapHeight;
+	engine.newGame();
+
+	std::printf(
+		"%d floors of %dx%d per generator, level %d. Medians:\n",
+		options.floors,
+		options.mapWidth,
+		options.mapHeight,
+		options.level);
+	std::printf(
+		"  %-6s %9s %9s %9s %8s %6s %6s %7s %8s %7s %9s\n",
+		"gen",
+		"total us",
+		"layout us",
+		"connect",
+		"walkable",
+		"rooms",
+		"groups",
+		"filled",
+		"farthest",
+		"stairs",
+		"dead ends");
+	for (int kind = 0; kind < MapGenerator::NB_KINDS; kind++) {
+		engine.mapGenerator = (MapGenerator::Kind)kind;
+		std::vector<FloorStats> floors;
+		for (int i = 0; i < options.floors; i++) floors.push_back(generateFloor(options, options.seed + i));
+		std::printf(
+			"  %-6s %9.1f %9.1f %9.1f %7.1f%% %6.0f %6.0f %7.0f %8.0f %7.0f %9.0f\n",
+			MapGenerator::getName((MapGenerator::Kind)kind),
+			median(floors, [](const FloorStats& f) { return f.generationUs; }),
+			median(floors, [](const FloorStats& f) { return f.layoutUs; }),
+			median(floors, [](const FloorStats& f) { return f.connectivityUs; }),
+			100.0 * median(floors, [](const FloorStats& f) { return f.walkable; }) /
+				(options.mapWidth * options.mapHeight),
+			median(floors, [](const FloorStats& f) { return f.rooms; }),
+			median(floors, [](const FloorStats& f) { return f.components; }),
+			median(floors, [](const FloorStats& f) { return f.filledTiles; }),
+			median(floors, [](const FloorStats& f) { return f.farthestDistance; }),
+			median(floors, [](const FloorStats& f) { return f.stairsDistance; }),
+			median(floors, [](const FloorStats& f) { return f.deadEnds; }));
+	}
+	engine.endGame();
+	benchCaveStep(options);
+	return 0;
+}
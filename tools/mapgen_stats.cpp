@@ -0,0 +1,299 @@
+// Bulk dungeon generation statistics.
+// Generates many floors per level through the regular Map::Map path, using fixed seeds and all cores, then reports
+// layout distributions and generation time percentiles. Every generated floor is written as a row to a CSV file.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "main.hpp"
+#include "toolsupport.hpp"
+
+struct FloorStats {
+	int level;
+	unsigned seed;
+	MapGenerator::Kind generator;
+	int rooms;
+	int walkable;
+	int stairDistance;	// in steps, -1 if unreachable
+	int farthestDistance;  // in steps from the player
+	int components;	 // groups of walkable tiles before unreachable ones were filled in
+	int filledTiles;
+	int items;
+	int monsters;
+	int corridors;
+	int corridorTotalLength;
+	int corridorMaxLength;
+	double generationUs;
+	double connectivityUs;	// part of generationUs spent in Map::connectAndPlaceStairs()
+};
+
+struct Options {
+	int floorsPerLevel = 200;
+	int firstLevel = 1;
+	int lastLevel = Content::NB_FLOORS;
+	int threads = 0;
+	int mapWidth = Engine::MAP_WIDTH, mapHeight = Engine::MAP_HEIGHT;
+	unsigned seed = 12345;
+	std::string csvPath = "mapgen_stats.csv";
+};
+
+static void printUsage() {
+	std::printf(
+		"Usage: mapgen-stats [--floors N] [--level L | --levels A-B] [--threads T] [--map-size WxH] [--seed S] "
+		"[--csv PATH]\n"
+		"  --floors N      floors generated per level (default 200)\n"
+		"  --level L       only generate floor L\n"
+		"  --levels A-B    generate floors A to B (default 1-20)\n"
+		"  --threads T     worker threads (default: all cores)\n"
+		"  --map-size WxH  size of the floors (default 72x32)\n"
+		"  --seed S        base seed, floor i of level L uses a seed derived from S, L and i (default 12345)\n"
+		"  --csv PATH      per-floor output (default mapgen_stats.csv)\n");
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--floors" && hasValue) {
+			options.floorsPerLevel = std::atoi(argv[++i]);
+		} else if (arg == "--level" && hasValue) {
+			options.firstLevel = options.lastLevel = std::atoi(argv[++i]);
+		} else if (arg == "--levels" && hasValue) {
+			if (std::sscanf(argv[++i], "%d-%d", &options.firstLevel, &options.lastLevel) != 2) return false;
+		} else if (arg == "--threads" && hasValue) {
+			options.threads = std::atoi(argv[++i]);
+		} else if (arg == "--csv" && hasValue) {
+			options.csvPath = argv[++i];
+		} else if (
+			!parseMapSizeOption(argc, argv, i, options.mapWidth, options.mapHeight) &&
+			!parseSeedOption(argc, argv, i, options.seed)) {
+			return false;
+		}
+	}
+	return options.floorsPerLevel > 0 && options.firstLevel >= 1 && options.lastLevel <= Content::NB_FLOORS &&
+		   options.firstLevel <= options.lastLevel;
+}
+
+// Steps needed to walk from (x1, y1) to (x2, y2) moving in 8 directions, -1 if unreachable
+static int walkingDistance(const Map& map, int x1, int y1, int x2, int y2) {
+	std::vector<int> dist(map.width * map.height, -1);
+	std::queue<std::pair<int, int>> queue;
+	dist[x1 + y1 * map.width] = 0;
+	queue.push({x1, y1});
+	while (!queue.empty()) {
+		auto [x, y] = queue.front();
+		queue.pop();
+		if (x == x2 && y == y2) return dist[x + y * map.width];
+		for (int dx = -1; dx <= 1; dx++)
+			for (int dy = -1; dy <= 1; dy++) {
+				int nx = x + dx, ny = y + dy;
+				if (nx < 0 || ny < 0 || nx >= map.width || ny >= map.height) continue;
+				if (dist[nx + ny * map.width] != -1 || !map.isWalkable(nx, ny)) continue;
+				dist[nx + ny * map.width] = dist[x + y * map.width] + 1;
+				queue.push({nx, ny});
+			}
+	}
+	return -1;
+}
+
+// Generate one floor on this thread's engine and measure it
+static FloorStats generateFloor(int level, unsigned seed) {
+	engine.clearFloor();
+	engine.level = level;
+	Random::instance().resetSeed(seed);
+
+	auto start = std::chrono::steady_clock::now();
+	engine.map = new Map(engine.mapWidth, engine.mapHeight);
+	double generationUs = elapsedUs(start);
+
+	const Map& map = *engine.map;
+	FloorStats stats = {};
+	stats.level = level;
+	stats.seed = seed;
+	stats.generationUs = generationUs;
+	stats.generator = map.layoutStats.generator;
+	stats.rooms = (int)map.rooms.size();
+	for (int x = 0; x < map.width; x++)
+		for (int y = 0; y < map.height; y++)
+			if (map.isWalkable(x, y)) stats.walkable++;
+	// Measured again independently of the generation pass, which must have left the stairs reachable
+	stats.stairDistance =
+		walkingDistance(map, engine.player->x, engine.player->y, engine.stairs->x, engine.stairs->y);
+	stats.farthestDistance = map.layoutStats.farthestDistance;
+	stats.components = map.layoutStats.components;
+	stats.filledTiles = map.layoutStats.filledTiles;
+	stats.connectivityUs = map.layoutStats.passUs;
+	for (auto actor : engine.actors) {
+		if (actor->pickable)
+			stats.items++;
+		else if (actor != engine.player && actor->destructible && !actor->destructible->isDead())
+			stats.monsters++;
+	}
+	stats.corridors = (int)map.corridorRecords.size();
+	for (auto [x1, y1, x2, y2] : map.corridorRecords) {
+		int length = std::abs(x2 - x1) + std::abs(y2 - y1) + 1;
+		stats.corridorTotalLength += length;
+		stats.corridorMaxLength = std::max(stats.corridorMaxLength, length);
+	}
+	return stats;
+}
+
+// Seeds only depend on the base seed, level and index, so results do not depend on the thread count
+static unsigned floorSeed(unsigned baseSeed, int level, int index) {
+	uint64_t h = baseSeed * 0x9E3779B97F4A7C15ULL + (uint64_t)level * 0xBF58476D1CE4E5B9ULL + (uint64_t)index;
+	h ^= h >> 31;
+	h *= 0x94D049BB133111EBULL;
+	h ^= h >> 29;
+	return (unsigned)h;
+}
+
+template <typename T>
+static double mean(const std::vector<T>& values) {
+	if (values.empty()) return 0.0;
+	double sum = 0.0;
+	for (auto value : values) sum += (double)value;
+	return sum / (double)values.size();
+}
+
+template <typename Getter>
+static void printDistribution(const char* name, const std::vector<FloorStats>& floors, Getter getter) {
+	std::vector<double> values;
+	values.reserve(floors.size());
+	for (const auto& floor : floors) values.push_back((double)getter(floor));
+	std::printf(
+		"  %-20s min %7.1f  p10 %7.1f  p50 %7.1f  p90 %7.1f  max %7.1f  mean %7.1f\n",
+		name,
+		percentile(values, 0.0),
+		percentile(values, 0.1),
+		percentile(values, 0.5),
+		percentile(values, 0.9),
+		percentile(values, 1.0),
+		mean(values));
+}
+
+static bool writeCsv(const std::string& path, const std::vector<FloorStats>& floors) {
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (!file) return false;
+	std::fprintf(
+		file,
+		"level,seed,generator,rooms,walkable,stair_distance,farthest_distance,components,filled_tiles,items,monsters,"
+		"corridors,corridor_total_length,corridor_max_length,generation_us,connectivity_us\n");
+	for (const auto& floor : floors)
+		std::fprintf(
+			file,
+			"%d,%u,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%.2f,%.2f\n",
+			floor.level,
+			floor.seed,
+			MapGenerator::getName(floor.generator),
+			floor.rooms,
+			floor.walkable,
+			floor.stairDistance,
+			floor.farthestDistance,
+			floor.components,
+			floor.filledTiles,
+			floor.items,
+			floor.monsters,
+			floor.corridors,
+			floor.corridorTotalLength,
+			floor.corridorMaxLength,
+			floor.generationUs,
+			floor.connectivityUs);
+	std::fclose(file);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	int nbThreads = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+	int nbLevels = options.lastLevel - options.firstLevel + 1;
+	int nbJobs = nbLevels * options.floorsPerLevel;
+
+	std::vector<FloorStats> results(nbJobs);
+	std::atomic<int> nextJob = 0;
+	auto worker = [&]() {
+		engine.mapWidth = options.mapWidth;
+		engine.mapHeight = options.mapHeight;
+		engine.newGame();
+		for (int job = nextJob++; job < nbJobs; job = nextJob++) {
+			int level = options.firstLevel + job / options.floorsPerLevel;
+			int index = job % options.floorsPerLevel;
+			results[job] = generateFloor(level, floorSeed(options.seed, level, index));
+		}
+		engine.endGame();
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int i = 0; i < nbThreads; i++) threads.emplace_back(worker);
+	for (auto& thread : threads) thread.join();
+	double elapsedS = elapsedUs(start) / 1e6;
+
+	std::printf(
+		"Generated %d floors (%d per level) on %d threads in %.2fs\n",
+		nbJobs,
+		options.floorsPerLevel,
+		nbThreads,
+		elapsedS);
+	for (int level = options.firstLevel; level <= options.lastLevel; level++) {
+		auto first = results.begin() + (level - options.firstLevel) * options.floorsPerLevel;
+		std::vector<FloorStats> floors(first, first + options.floorsPerLevel);
+		int unreachable = 0;
+		for (const auto& floor : floors)
+			if (floor.stairDistance < 0) unreachable++;
+		std::printf("Floor %d (unreachable stairs: %d)\n", level, unreachable);
+		printDistribution("rooms", floors, [](const FloorStats& f) { return f.rooms; });
+		printDistribution("walkable tiles", floors, [](const FloorStats& f) { return f.walkable; });
+		printDistribution("stair distance", floors, [](const FloorStats& f) { return f.stairDistance; });
+		printDistribution("stairs / farthest", floors, [](const FloorStats& f) {
+			return f.farthestDistance ? (double)f.stairDistance / f.farthestDistance : 0.0;
+		});
+		printDistribution("components", floors, [](const FloorStats& f) { return f.components; });
+		printDistribution("filled tiles", floors, [](const FloorStats& f) { return f.filledTiles; });
+		printDistribution("items", floors, [](const FloorStats& f) { return f.items; });
+		printDistribution("monsters", floors, [](const FloorStats& f) { return f.monsters; });
+		printDistribution("corridors", floors, [](const FloorStats& f) { return f.corridors; });
+		printDistribution("corridor length", floors, [](const FloorStats& f) {
+			return f.corridors ? (double)f.corridorTotalLength / f.corridors : 0.0;
+		});
+		printDistribution("longest corridor", floors, [](const FloorStats& f) { return f.corridorMaxLength; });
+	}
+
+	std::vector<double> times, connectivityTimes;
+	times.reserve(results.size());
+	connectivityTimes.reserve(results.size());
+	for (const auto& floor : results) {
+		times.push_back(floor.generationUs);
+		connectivityTimes.push_back(floor.connectivityUs);
+	}
+	std::printf(
+		"Generation time (us): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+		percentile(times, 0.5),
+		percentile(times, 0.9),
+		percentile(times, 0.99),
+		percentile(times, 1.0));
+	std::printf(
+		"  of which connectivity and stairs (us): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+		percentile(connectivityTimes, 0.5),
+		percentile(connectivityTimes, 0.9),
+		percentile(connectivityTimes, 0.99),
+		percentile(connectivityTimes, 1.0));
+
+	if (!writeCsv(options.csvPath, results)) {
+		std::fprintf(stderr, "Could not write %s\n", options.csvPath.c_str());
+		return 1;
+	}
+	std::printf("Wrote %s\n", options.csvPath.c_str());
+	return 0;
+}
@@ -0,0 +1,176 @@
+// Spatial index benchmark.
+// Scatters 10, 100 and 10,000 actors over a map sized to keep the same crowd density, then times the range queries
+// of the game (area spells, heal searches, closest monster, k nearest) and moving every actor, both through
+// SpatialIndex and by scanning the whole list as the game used to. Results of both are checked to agree.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "main.hpp"
+#include "toolsupport.hpp"
+
+struct Options {
+	int queries = 100000;
+	unsigned seed = 12345;
+};
+
+static void printUsage() {
+	std::printf(
+		"Usage: spatial-bench [--queries N] [--seed S]\n"
+		"  --queries N  queries timed per kind and actor count (default 100000)\n"
+		"  --seed S     seed for actor and query positions (default 12345)\n");
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--queries" && hasValue) {
+			options.queries = std::atoi(argv[++i]);
+		} else if (!parseSeedOption(argc, argv, i, options.seed)) {
+			return false;
+		}
+	}
+	return options.queries > 0;
+}
+
+static int distance2(const Actor* actor, int x, int y) {
+	return (actor->x - x) * (actor->x - x) + (actor->y - y) * (actor->y - y);
+}
+
+static bool isLiving(const Actor* actor) { return actor->destructible && !actor->destructible->isDead(); }
+
+static bool isWounded(const Actor* actor) {
+	return isLiving(actor) && actor->destructible->hp < actor->destructible->maxHp;
+}
+
+// Average nanoseconds per call of query(x, y) over the query positions
+template <typename Query>
+static double timeQueries(const std::vector<std::pair<int, int>>& positions, Query query) {
+	auto start = std::chrono::steady_clock::now();
+	for (auto [x, y] : positions) query(x, y);
+	return elapsedUs(start) * 1000.0 / positions.size();
+}
+
+static void run(int nbActors, const Options& options) {
+	// About one actor every 8 tiles, as on a crowded floor
+	int side = std::max(32, (int)std::sqrt(nbActors * 8.0));
+	std::mt19937 rng(options.seed);
+	std::uniform_int_distribution<int> coordinate(0, side - 1);
+
+	SpatialIndex index(side, side);
+	std::vector<Actor*> actors;
+	for (int i = 0; i < nbActors; i++) {
+		Actor* actor = new Actor(coordinate(rng), coordinate(rng), 'o', "orc", {63, 127, 63});
+		actor->destructible = new MonsterDestructible(10, 0, "dead orc");
+		if (rng() % 2) actor->destructible->hp = 5;
+		actors.push_back(actor);
+		index.insert(actor);
+	}
+	std::vector<std::pair<int, int>> positions(options.queries);
+	for (auto& position : positions) position = {coordinate(rng), coordinate(rng)};
+
+	std::printf("%d actors on a %dx%d map\n", nbActors, side, side);
+	std::printf("  %-28s %12s %12s %9s\n", "query", "scan ns", "index ns", "speedup");
+	auto report = [&](const char* name, double scanNs, double indexNs) {
+		std::printf("  %-28s %12.1f %12.1f %8.1fx\n", name, scanNs, indexNs, scanNs / indexNs);
+	};
+	int mismatches = 0;
+	long long checksum = 0;
+
+	// Area spell, every living actor within 5 tiles
+	std::vector<Actor*> scanList, indexList;
+	double scanNs = timeQueries(positions, [&](int x, int y) {
+		scanList.clear();
+		for (auto actor : actors)
+			if (isLiving(actor) && distance2(actor, x, y) <= 25) scanList.push_back(actor);
+		checksum += scanList.size();
+	});
+	double indexNs = timeQueries(positions, [&](int x, int y) {
+		indexList.clear();
+		index.forEachInRadius(x, y, 5.0F, [&](Actor* actor) {
+			if (isLiving(actor)) indexList.push_back(actor);
+		});
+		checksum -= indexList.size();
+	});
+	report("radius 5", scanNs, indexNs);
+	if (checksum != 0) mismatches++;
+
+	// Heal search, closest wounded actor within 5 tiles
+	auto nearestScan = [&](int x, int y, int maxDistance2, auto predicate) {
+		Actor* nearest = NULL;
+		int best = maxDistance2 + 1;
+		for (auto actor : actors)
+			if (predicate(actor) && distance2(actor, x, y) < best) {
+				best = distance2(actor, x, y);
+				nearest = actor;
+			}
+		return nearest;
+	};
+	// Ties can pick different actors, so compare distances
+	auto compare = [&](Actor* scanned, Actor* indexed, int x, int y) {
+		if ((scanned == NULL) != (indexed == NULL) || (scanned && distance2(scanned, x, y) != distance2(indexed, x, y)))
+			mismatches++;
+	};
+	for (int i = 0; i < std::min(options.queries, 1000); i++) {
+		auto [x, y] = positions[i];
+		compare(nearestScan(x, y, 25, isWounded), index.findNearest(x, y, 5.0F, isWounded), x, y);
+		compare(nearestScan(x, y, 1 << 30, isLiving), index.findNearest(x, y, 0.0F, isLiving), x, y);
+	}
+	scanNs = timeQueries(positions, [&](int x, int y) { checksum += nearestScan(x, y, 25, isWounded) != NULL; });
+	indexNs = timeQueries(positions, [&](int x, int y) { checksum += index.findNearest(x, y, 5.0F, isWounded) != NULL; });
+	report("nearest wounded within 5", scanNs, indexNs);
+
+	// Closest monster at any distance
+	scanNs = timeQueries(positions, [&](int x, int y) { checksum += nearestScan(x, y, 1 << 30, isLiving) != NULL; });
+	indexNs = timeQueries(positions, [&](int x, int y) { checksum += index.findNearest(x, y, 0.0F, isLiving) != NULL; });
+	report("nearest at any distance", scanNs, indexNs);
+
+	// 8 nearest
+	std::vector<std::pair<int, Actor*>> sorted;
+	scanNs = timeQueries(positions, [&](int x, int y) {
+		sorted.clear();
+		for (auto actor : actors)
+			if (isLiving(actor)) sorted.push_back({distance2(actor, x, y), actor});
+		int k = std::min(8, (int)sorted.size());
+		std::partial_sort(sorted.begin(), sorted.begin() + k, sorted.end(), [](const auto& a, const auto& b) {
+			return a.first < b.first;
+		});
+		checksum += k;
+	});
+	indexNs = timeQueries(positions, [&](int x, int y) {
+		index.findNearest(x, y, 8, 0.0F, isLiving, indexList);
+		checksum += indexList.size();
+	});
+	report("8 nearest", scanNs, indexNs);
+
+	// Every actor takes a random step, as in a turn
+	std::uniform_int_distribution<int> step(-1, 1);
+	int nbTurns = std::max(1, options.queries / nbActors);
+	auto start = std::chrono::steady_clock::now();
+	for (int turn = 0; turn < nbTurns; turn++)
+		for (auto actor : actors)
+			actor->moveTo(std::clamp(actor->x + step(rng), 0, side - 1), std::clamp(actor->y + step(rng), 0, side - 1));
+	double moveNs = elapsedUs(start) * 1000.0 / ((double)nbTurns * nbActors);
+	std::printf("  %-28s %25.1f\n", "index update per move", moveNs);
+	if (mismatches > 0) std::printf("  %d MISMATCHES between scan and index\n", mismatches);
+	std::printf("  (checksum %lld)\n", checksum);
+
+	for (auto actor : actors) delete actor;
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+	for (int nbActors : {10, 100, 10000}) run(nbActors, options);
+	return 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Helpers shared by the headless tools of this directory
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "main.hpp"
+
+// Value at fraction p of the sorted values, from 0 for the smallest to 1 for the largest, 0 if there are none
+inline double percentile(std::vector<double> values, double p) {
+	if (values.empty()) return 0.0;
+	std::sort(values.begin(), values.end());
+	size_t index = (size_t)(p * (double)(values.size() - 1) + 0.5);
+	return values[std::min(index, values.size() - 1)];
+}
+
+// Options shared by the tools, read when argv[i] is the option and a value follows, moving i onto the value. False
+// otherwise, or when the value is invalid.
+inline bool parseSeedOption(int argc, char** argv, int& i, unsigned& seed) {
+	if (std::strcmp(argv[i], "--seed") != 0 || i + 1 >= argc) return false;
+	seed = (unsigned)std::strtoul(argv[++i], NULL, 10);
+	return true;
+}
+
+inline bool parseMapSizeOption(int argc, char** argv, int& i, int& width, int& height) {
+	if (std::strcmp(argv[i], "--map-size") != 0 || i + 1 >= argc || !Map::parseSize(argv[i + 1], width, height))
+		return false;
+	i++;
+	return true;
+}